@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// ----------------------------------------------------------------------------
+// bulk kernels for the axis transformations (used by Axis, not by the user)
+//
+// all kernels evaluate an affine map a*v + b on n contiguous values, combined
+// with the log10 or 10^v required for logarithmic axis:
+//
+//   affine:        out[i] = a * in[i] + b
+//   log10_affine:  out[i] = a * log10(in[i]) + b
+//   affine_exp10:  out[i] = 10^(a * in[i] + b)
+//
+// in and out may be identical (in-place transformation), but must not overlap
+// otherwise.
+//
+// the implementation is selected once at runtime depending on the cpu
+// (avx2+fma, sse2 or scalar). log10 and 10^v are evaluated by polynomial
+// approximations with a relative error < 1e-12; vectors containing special
+// values (<= 0, denormals, inf, nan, overflow) are handed over to the std
+// library functions to preserve their exact semantics.
+// ----------------------------------------------------------------------------
+
+void axis_affine(const double* in, double* out, std::size_t n, double a, double b);
+void axis_log10_affine(const double* in, double* out, std::size_t n, double a,
+                       double b);
+void axis_affine_exp10(const double* in, double* out, std::size_t n, double a,
+                       double b);
+
+// name of the kernel set selected at runtime ("avx2", "sse2" or "scalar")
+const char* axis_kernels_isa();
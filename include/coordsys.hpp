@@ -1,12 +1,23 @@
 #pragma once
 
+#include "cs_style.hpp"
+#include "label_cache.hpp"
+
 #include <QPainter>
 #include <QString>
 #include <QWidget>
 
+#include <cmath> // NAN
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+// globally unique, increasing stamps to identify the rendered state of objects
+// (copies keep the stamp of the state they were copied from)
+std::uint64_t new_version_stamp();
+
 struct mouse_pos_t // mouse position in various systems
 {
     int nx, ny;  // pos in device coordinate system
@@ -126,7 +137,20 @@ class Axis // defines axis and scaling transformation to paint device
     double w_to_a(int npos) const;            // widget to (scaled) axis transformation
     double w_to_au(int npos) const;           // widget to unscaled axis transformation
 
-    void draw(QPainter* qp, int offset);
+    // bulk transformations of whole columns (npos not truncated to int)
+    // out must provide at least as many elements as in (in-place allowed)
+    void au_to_w(std::span<const double> unscaled_values, std::span<double> npos) const;
+    void w_to_au(std::span<const double> npos, std::span<double> unscaled_values) const;
+
+    // notch labels are taken from labels, label_advance is the advance of the
+    // axis label in the label font of st (both kept by the Coordsys when the
+    // axis is rebuilt on pan and zoom)
+    void draw(QPainter* qp, int offset, const cs_style& st, Label_cache& labels,
+              int label_advance);
+
+    // axis covering [n1, n2] on the paint device only, with the same
+    // transformation and ticks (e.g. to render a strip of the cs area)
+    Axis part(int n1, int n2) const;
 
     double min() const { return ad.rng.min; } // min as scaled value
     double max() const { return ad.rng.max; } // max as scaled value
@@ -137,9 +161,13 @@ class Axis // defines axis and scaling transformation to paint device
     axis_scal scaling() const { return ad.scal; }
     widget_axis_data get_widget_axis_data() const { return wd; }
     axis_data get_axis_data() const { return ad; }
+    const QString& get_label() const { return label; }
 
-    std::vector<double> get_major_pos() const;
-    std::vector<double> get_minor_pos(const std::vector<double>& major_pos) const;
+    // positions of the major and minor notches (scaled values) in and around the
+    // visible range, computed in closed form and cached until range, scaling or
+    // ticks change (the references are valid until the next change of the axis)
+    const std::vector<double>& get_major_pos() const;
+    const std::vector<double>& get_minor_pos() const;
 
   private:
 
@@ -153,6 +181,22 @@ class Axis // defines axis and scaling transformation to paint device
     int mo;    // min offset position on paint device
     double sf; // scaling factor to map axis length and scaling direction to
                // length and direction on paint device
+
+    // notches of the last call of get_major_pos/get_minor_pos and the axis data
+    // they were computed for
+    struct tick_cache {
+        axis_rng rng{NAN, NAN}; // nan: not computed yet
+        axis_scal scal{axis_scal::linear};
+        axis_ticks ticks;
+        std::vector<double> major;
+        std::vector<double> minor;
+    };
+    mutable tick_cache tc;
+
+    static constexpr int max_major_ticks{200};  // more major notches are thinned
+    static constexpr int max_minor_ticks{2000}; // more minor notches are skipped
+
+    void update_ticks() const;
 };
 
 struct coordsys_data {
@@ -170,16 +214,43 @@ struct coordsys_data {
     double y_rng_major_delta_target_ratio{};
 };
 
+struct view_state // what the user changes by pan and zoom (e.g. for undo)
+{
+    axis_rng x_rng, y_rng; // scaled values
+    double x_major_delta{1.0}, y_major_delta{1.0};
+    axis_scal x_scal{axis_scal::linear}, y_scal{axis_scal::linear};
+};
+
 class Coordsys {
   public:
 
     Coordsys(Axis x_in, Axis y_in, coordsys_data cd_in);
-    void draw(QPainter* qp);
+    void draw(QPainter* qp); // draw_grid and draw_axes, clips to the cs area
+    void draw_grid(QPainter* qp); // helper lines through major notches (in cs area)
+    void draw_axes(QPainter* qp); // axes, notches, labels, frame and title
+
+    // coordsys of the part r (within the cs area) of the paint device: same
+    // transformation, but drawing and culling of models are restricted to r
+    Coordsys part(const QRect& r) const;
 
     coordsys_data get_coordsys_data() const { return cd; }
+
+    // changes with each adjust_to_... call (for caching of rendered output)
+    // ATTENTION: direct assignments to x or y do not change the version (nor
+    // are changed axis labels measured again before the next set_theme)
+    std::uint64_t version() const { return m_version; }
     double get_xtarget_ratio() const { return cd.x_rng_major_delta_target_ratio; }
     double get_ytarget_ratio() const { return cd.y_rng_major_delta_target_ratio; }
 
+    // fonts, metrics and pens used for drawing (resolved once per theme)
+    const cs_style& style() const { return *st; }
+    void set_theme(const cs_theme& t); // changes the version
+
+    // ranges, notch distances and scaling of both axes, a view_state set is
+    // applied to the current widget size (changes the version)
+    view_state get_view_state() const;
+    void set_view_state(const view_state& vs);
+
     void adjust_to_resized_widget(int new_w_width, int new_w_height);
     void adjust_to_pan(double dx, double dy);
     void adjust_to_zoom(double new_xmin, double new_xmax, double new_ymin,
@@ -204,4 +275,17 @@ class Coordsys {
 
     // title as qt-String
     QString title;
+
+    // shared by copies (immutable, replaced by set_theme)
+    std::shared_ptr<const cs_style> st{std::make_shared<const cs_style>()};
+    // prepared notch labels of both axes, shared by copies (e.g. for rendering
+    // on another thread) and kept when the axes are rebuilt on pan and zoom
+    std::shared_ptr<Label_cache> tick_labels{std::make_shared<Label_cache>()};
+    // advances of the axis labels and the title (measured once per style)
+    std::uint64_t measured_style{0}; // id of style the advances were measured with
+    int x_label_advance{0};
+    int y_label_advance{0};
+    int title_advance{0};
+
+    std::uint64_t m_version;
 };
\ No newline at end of file
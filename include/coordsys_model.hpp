@@ -1,11 +1,28 @@
 #pragma once
 
 #include "coordsys.hpp"
+#include "kd_tree.hpp"
+#include "ring_series.hpp"
+#include "spatial_grid.hpp"
+#include "style_table.hpp"
 
+#include <QImage>
+#include <QLine>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QPixmap>
+#include <QPointF>
+#include <QRect>
 #include <cassert> // attribute [[maybe_unused]]
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <unordered_map>
 #include <vector>
 
 #include "fmt/format.h"
@@ -39,10 +56,27 @@ struct pt2d_mark
 
     int grp{0}; // user provided group the
                 // item shall belong to (for selection)
+
+    bool operator==(const pt2d_mark&) const = default;
+};
+
+struct pt2d_mark_hash
+{
+    std::size_t operator()(const pt2d_mark& m) const
+    {
+        std::size_t h = std::hash<int>{}(m.symbol);
+        hash_combine(h, std::hash<int>{}(m.nsize));
+        hash_combine(h, pen_hash(m.pen));
+        hash_combine(h, std::hash<int>{}(m.grp));
+        return h;
+    }
 };
 
 const pt2d_mark pt2d_mark_default; // for default arguments
 
+// draw symbol of size nsize centered at (nx, ny) with the current pen of qp
+void draw_symbol(QPainter* qp, Symbol symbol, int nx, int ny, int nsize);
+
 // this struct should be used by the user to mark lines
 struct ln2d_mark
 {
@@ -58,6 +92,23 @@ struct ln2d_mark
 
     int grp{0}; // user provided group the
                 // item shall belong to (for selection)
+
+    bool operator==(const ln2d_mark&) const = default;
+};
+
+struct ln2d_mark_hash
+{
+    std::size_t operator()(const ln2d_mark& m) const
+    {
+        std::size_t h = pen_hash(m.pen);
+        hash_combine(h, std::hash<bool>{}(m.mark_pts));
+        hash_combine(h, std::hash<int>{}(m.delta));
+        hash_combine(h, pt2d_mark_hash{}(m.pm));
+        hash_combine(h, std::hash<bool>{}(m.mark_area));
+        hash_combine(h, std::hash<QRgb>{}(m.area_col.rgba()));
+        hash_combine(h, std::hash<int>{}(m.grp));
+        return h;
+    }
 };
 
 const ln2d_mark ln2d_mark_default; // for default arguments;
@@ -78,6 +129,18 @@ struct vec2d_mark
 
     int grp{0}; // user provided group the
                 // item shall belong to (for selection)
+
+    bool operator==(const vec2d_mark&) const = default;
+};
+
+struct vec2d_mark_hash
+{
+    std::size_t operator()(const vec2d_mark& m) const
+    {
+        std::size_t h = pen_hash(m.pen);
+        hash_combine(h, std::hash<int>{}(m.grp));
+        return h;
+    }
 };
 
 const vec2d_mark vec2d_mark_default; // for default arguments;
@@ -95,6 +158,84 @@ struct mark_id
     bool active{true};    // active elements are diplayed (on by default)
 };
 
+// vertices of a line as x and y columns or as array of pt2d (interleaved
+// coordinates are accessed as members of the pt2d, not by pointer arithmetic
+// over doubles)
+struct ln_view
+{
+    const double* x{nullptr}; // columns (if pts == nullptr)
+    const double* y{nullptr};
+    const pt2d* pts{nullptr}; // interleaved
+    std::size_t n{0};         // number of vertices
+
+    double xv(std::size_t j) const { return pts ? pts[j].x : x[j]; }
+    double yv(std::size_t j) const { return pts ? pts[j].y : y[j]; }
+};
+
+// position of marker symbol (sprite) on paint device
+struct marker_inst
+{
+    int nx, ny; // center of symbol
+    int sprite; // sprite id provided by Marker_atlas
+};
+
+class Marker_atlas // pre-rendered marker symbols (sprites) for fast drawing of
+                   // many points: each distinct (symbol, nsize, pen) is rendered
+                   // once and then copied to the positions of all its points
+
+// the atlas is re-rendered when new sprites were added or the device pixel ratio
+// or antialiasing of the target changed; clear() drops all sprites
+{
+  public:
+
+    // sprite id for mark m (created on first use), -1 if m is too large to be
+    // pre-rendered (such marks have to be drawn directly with draw_symbol)
+    int sprite(const pt2d_mark& m);
+    void clear();
+
+    // copy the sprites into the paint device of qp (in order of inst): in the
+    // gui thread with a single drawPixmapFragments call, elsewhere (no pixmaps
+    // there) directly into the pixels of the target image
+    void draw(QPainter* qp, const std::vector<marker_inst>& inst);
+
+  private:
+
+    struct sprite_key
+    {
+        Symbol symbol;
+        int nsize;
+        QRgb color;
+        qreal width;
+        Qt::PenStyle style;
+        Qt::PenCapStyle cap;
+        Qt::PenJoinStyle join;
+
+        bool operator==(const sprite_key&) const = default;
+    };
+    struct sprite_key_hash
+    {
+        std::size_t operator()(const sprite_key& k) const;
+    };
+
+    std::unordered_map<sprite_key, int, sprite_key_hash> ids;
+    std::vector<pt2d_mark> marks; // mark per sprite id
+    std::vector<QRect> rects;     // sprite positions in atlas (device pixels)
+
+    QImage atlas;
+    bool dirty{true}; // sprites added since last rendering of atlas
+    qreal atlas_dpr{0.0};
+    bool atlas_aa{false};
+    QPixmap atlas_pm;    // atlas for drawing in the gui thread
+    bool pm_dirty{true}; // atlas re-rendered since last conversion to atlas_pm
+    std::vector<QPainter::PixmapFragment> frags; // reused by draw
+
+    static constexpr int max_sprite_size{64}; // in device independent pixels
+    static constexpr int atlas_width{1024};   // in device pixels
+
+    void render(qreal dpr, bool aa);
+    bool blend_into_image(QPainter* qp, const std::vector<marker_inst>& inst) const;
+};
+
 // ----------------------------------------------------------------------------
 // this is used internally up to here, not by the user directly
 // ----------------------------------------------------------------------------
@@ -105,50 +246,438 @@ struct mark_id
 using ln2d = std::vector<pt2d>;
 // ----------------------------------------------------------------------------
 
+// rendering path for lines
+// segments: one drawLine call per segment (each vertex is transformed twice)
+// polyline: each vertex is transformed once into a reused buffer and the whole
+//           line is handed over to drawPolyline in chunks
+//           lines with ascending x values are restricted to the visible x range
+//           and reduced to first/min/max/last vertex per pixel column (m4)
+enum class ln_draw { segments, polyline };
+
+// rendering path for point marks
+// symbols: each mark is stroked with its pen (1 to 4 draw calls per point)
+// sprites: marks are pre-rendered once per style and copied to their positions
+enum class pt_draw { symbols, sprites };
+
+// timing of the line rendering path of the last call to draw()
+struct draw_stats
+{
+    std::size_t n_vertices{0}; // number of line vertices drawn
+    double t_draw{0.0};        // time spent for drawing the lines [s]
+
+    double vertices_per_sec() const { return t_draw > 0.0 ? n_vertices / t_draw : 0.0; }
+};
+
+// item found by Coordsys_model::pick
+struct pick_result
+{
+    bool is_point{true};   // point (incl. marks of line vertices) or line vertex
+    int id{-1};            // id of point or line
+    int linked_to_id{-1};  // id of line, if the point marks a vertex of it
+    int grp{0};            // group of point or line
+    std::size_t vertex{0}; // index of vertex in line (lines and their marks)
+    pt2d p;                // coordinates of the item
+    double dist{0.0};      // distance to the queried position [pixels]
+};
+
 class Coordsys_model
 {
   public:
 
-    void draw(QPainter* qp, Coordsys* cs);
+    Coordsys_model() = default;
+    Coordsys_model(const Coordsys_model&) = default;
+    Coordsys_model(Coordsys_model&&) = default;
+    Coordsys_model& operator=(const Coordsys_model&) = default;
+    Coordsys_model& operator=(Coordsys_model&&) = default;
+    ~Coordsys_model() { pick_next.reset(); } // before the data is destroyed
+
+    // number of samples of each stream drawn into a frame (see draw_appended)
+    using stream_state = std::vector<std::uint64_t>;
+
+    // stop allows to cancel drawing from another thread (e.g. for outdated frames)
+    // drawn receives the state of the streams as drawn
+    void draw(QPainter* qp, Coordsys* cs, std::stop_token stop = {},
+              stream_state* drawn = nullptr);
 
     // add single point
     [[maybe_unused]] int add_p(const pt2d& p_in,
-                               const pt2d_mark m = pt2d_mark_default);
-    // add single line
+                               const pt2d_mark& m = pt2d_mark_default);
+    // add points with the same mark (consecutive ids, returns id of first point)
+    [[maybe_unused]] int add_p(std::span<const pt2d> vp_in,
+                               const pt2d_mark& m = pt2d_mark_default);
+
+    // add single line (vertices are copied into the model)
     [[maybe_unused]] int add_l(const std::vector<pt2d>& vp_in,
-                               const ln2d_mark m = ln2d_mark_default);
+                               const ln2d_mark& m = ln2d_mark_default);
+    [[maybe_unused]] int add_l(std::span<const pt2d> vp_in,
+                               const ln2d_mark& m = ln2d_mark_default);
+    [[maybe_unused]] int add_l(std::span<const double> x_in,
+                               std::span<const double> y_in,
+                               const ln2d_mark& m = ln2d_mark_default);
+    // add single line, the model takes over the vertices w/o copying them
+    [[maybe_unused]] int add_l(std::vector<pt2d>&& vp_in,
+                               const ln2d_mark& m = ln2d_mark_default);
+    // add single line, the model shares the x and y columns w/o copying them
+    // (e.g. one x column for several lines), the columns must not be modified
+    // by other owners
+    [[maybe_unused]] int add_l(std::shared_ptr<const std::vector<double>> x_in,
+                               std::shared_ptr<const std::vector<double>> y_in,
+                               const ln2d_mark& m = ln2d_mark_default);
+    // add single line as view of external vertices w/o copying them
+    // the caller keeps ownership: the data must stay valid and unchanged as long
+    // as the line is part of the model or of any copy of it (until clear())
+    [[maybe_unused]] int add_l_view(std::span<const pt2d> vp_in,
+                                    const ln2d_mark& m = ln2d_mark_default);
+    [[maybe_unused]] int add_l_view(std::span<const double> x_in,
+                                    std::span<const double> y_in,
+                                    const ln2d_mark& m = ln2d_mark_default);
+
     // add vector
     [[maybe_unused]] int add_v(const vec2d& v_in,
-                               const vec2d_mark m = vec2d_mark_default);
+                               const vec2d_mark& m = vec2d_mark_default);
+
+    // add streaming series (line with the latest capacity samples), returns id
+    [[maybe_unused]] int add_stream(std::size_t capacity,
+                                    const ln2d_mark& m = ln2d_mark_default);
+    // series of stream with id for appending samples (from any thread)
+    // (appending does not change the version of the model: use draw_appended to
+    // add new samples to a frame that is still valid otherwise)
+    Ring_series& stream(int id);
+    std::size_t n_streams() const { return streams.size(); }
+
+    // streams got new samples since drawn
+    bool streams_appended(const stream_state& drawn) const;
+    // draw only the samples appended since drawn (connected to the last sample
+    // drawn before) and update drawn, can be called concurrently with draw()
+    void draw_appended(QPainter* qp, Coordsys* cs, stream_state& drawn) const;
+    // largest x value of the latest samples of all streams (false if no samples)
+    bool streams_last_x(double& x) const;
+    // changes whenever a stream is cleared: its samples drawn before can only be
+    // removed by a full frame (so this is part of the key of a frame)
+    std::uint64_t streams_epoch() const;
+
+    // groups (grp of the marks): all items of a group are shown or hidden at once
+    // (O(1), hidden groups are skipped by draw and pick as a whole)
+    void set_group_visible(int grp, bool visible);
+    bool group_visible(int grp) const;
+    // ids of the points, lines and vectors of a group (in ascending order)
+    std::vector<int> group_ids(int grp) const;
+
+    // items with ids in [first_id, last_id]: only active items are displayed
+    // (marks of line vertices follow their line)
+    void set_active(int first_id, int last_id, bool active);
+
+    // selection of items: an item is selected if its group or the item itself
+    // is selected (selecting an id range does not change selected groups,
+    // marks of line vertices follow their line)
+    // selected items are highlighted with the select_pen of the theme of the
+    // coordsys (on top of all items)
+    void select_group(int grp, bool selected = true);
+    void select(int first_id, int last_id, bool selected = true);
+    void clear_selection();
+    std::vector<int> selected_ids() const; // in ascending order
+
+    // item (point or line vertex) nearest to the widget position (nx, ny) within
+    // tol pixels; false if there is none
+    // the k-d tree of the items is built on a worker thread after a change of the
+    // model (or of the scaling of the axes), calls return false until it is
+    // ready and cost O(log n) after that
+    bool pick(Coordsys* cs, int nx, int ny, int tol, pick_result& r);
 
     void set_label(const std::string& new_label);
     std::string label() { return m_label; }
 
+    // select rendering path for lines (polyline by default), the vertices/s
+    // figures of the last draw are available from ln_draw_stats
+    void set_ln_draw(ln_draw mode);
+    draw_stats ln_draw_stats() const { return ln_stats; }
+
+    // select rendering path for point marks (sprites by default)
+    void set_pt_draw(pt_draw mode);
+
     // reset model to empty state, e.g. for reuse in new model
     void clear();
 
+    // changes with each modification of the model that affects its rendering
+    std::uint64_t version() const { return m_version; }
+
   private:
 
+    struct pick_index
+    {
+        Kd_tree tree;
+        std::uint64_t version{0}; // version of the model in tree
+        axis_scal xscal{axis_scal::linear};
+        axis_scal yscal{axis_scal::linear};
+        std::size_t n_pts{0};
+        std::vector<std::size_t> ln_first; // first vertex index of each line
+    };
+
+    // pick tree being built on a worker thread from the data of the model: it is
+    // finished before the model is modified, replaced, moved from or destroyed
+    struct pick_job
+    {
+        std::future<std::shared_ptr<const pick_index>> f;
+
+        pick_job() = default;
+        pick_job(const pick_job&) {} // a copy starts w/o job
+        pick_job(pick_job&& other) { other.reset(); }
+        pick_job& operator=(const pick_job&)
+        {
+            reset();
+            return *this;
+        }
+        pick_job& operator=(pick_job&& other)
+        {
+            reset();
+            other.reset();
+            return *this;
+        }
+        void reset()
+        {
+            if (f.valid()) f.wait();
+            f = {};
+        }
+    };
+    // first member: assignments finish the job before the data is replaced
+    pick_job pick_next;
+
     int unique_id{0}; // id = unique id, e.g. to identify each item in model
                       // assigned when model is setup using push_back calls
 
-    // data for points (same index is for same point)
-    std::vector<pt2d> pt;
-    std::vector<pt2d_mark> pt_mark;
-    std::vector<mark_id> pt_id;
+    std::uint64_t m_version{new_version_stamp()};
+
+    // data for points (columnar, same index is for same point)
+    std::vector<double> pt_x;
+    std::vector<double> pt_y;
+    std::vector<std::uint32_t> pt_style; // index of mark in pt_styles
+    std::vector<bool> pt_active;         // active points are displayed
+
+    // distinct marks of points and their sprite ids in pt_atlas (-1: draw
+    // directly)
+    Style_table<pt2d_mark, pt2d_mark_hash> pt_styles;
+    std::vector<int> pt_style_sprite;
+
+    // ids of points as runs of consecutive ids with the same link
+    // (points added by add_p in a row)
+    struct pt_id_run
+    {
+        std::size_t first; // index of first point of run
+        int first_id;      // id of first point of run
+        int linked_to_id;
+    };
+    std::vector<pt_id_run> pt_id_runs;
+
+    std::vector<bool> pt_selected;
+
+    std::uint32_t pt_style_idx(const pt2d_mark& m);
+    int pt_id(std::size_t i) const;
+    void push_pt(const pt2d& p, std::uint32_t style, int linked_to_id);
 
     // data for lines (same index is for same line)
-    std::vector<ln2d> line;
-    std::vector<ln2d_mark> line_mark;
+    // vertices of copied lines are stored contiguously as x and y columns (csr),
+    // lines taken over by the model are kept as they are, shared columns are
+    // held by the model, and external lines are referenced only
+    enum class ln_store { arena, adopted, shared, external };
+    struct ln_ref
+    {
+        ln_store store{ln_store::arena};
+        std::size_t pos{0}; // first vertex in line_x, line_y (arena) or index
+                            // in line_adopted (adopted) or line_shared (shared)
+        std::size_t n{0};   // number of vertices
+        ln_view ext;        // vertices (external)
+    };
+    struct ln_cols
+    {
+        std::shared_ptr<const std::vector<double>> x;
+        std::shared_ptr<const std::vector<double>> y;
+    };
+    std::vector<double> line_x;
+    std::vector<double> line_y;
+    std::vector<ln2d> line_adopted;
+    std::vector<ln_cols> line_shared;
+    std::vector<ln_ref> line_ref;
+    std::vector<std::uint32_t> line_style; // index of mark in line_styles
     std::vector<mark_id> line_id;
+    std::vector<bool> line_sorted; // x values in ascending order (allows culling
+                                   // and decimation when drawing)
+    std::vector<bool> line_selected;
+
+    // marked vertices of lines (every delta-th vertex of line, drawn as points
+    // with consecutive ids starting at first_id)
+    struct ln_pt_marks
+    {
+        std::size_t line;
+        int delta;
+        std::uint32_t style; // index of mark in pt_styles
+        int first_id;
+        int n_marks;
+    };
+    std::vector<ln_pt_marks> line_pt_marks;
+
+    std::size_t n_lines() const { return line_ref.size(); }
+    ln_view ln_vertices(std::size_t i) const;
+    int push_ln(const ln_ref& r, const ln2d_mark& m);
 
     // data for vectors (same index is for same vector)
     std::vector<vec2d> vec;
-    std::vector<vec2d_mark> vec_mark;
+    std::vector<std::uint32_t> vec_style; // index of mark in vec_styles
     std::vector<mark_id> vec_id;
+    std::vector<bool> vec_selected;
+
+    // distinct marks of lines and vectors
+    Style_table<ln2d_mark, ln2d_mark_hash> line_styles;
+    Style_table<vec2d_mark, vec2d_mark_hash> vec_styles;
+
+    // groups: dense index per distinct grp value, the group of an item is given
+    // by its style (the marks contain grp)
+    struct grp_data
+    {
+        int grp;
+        bool hidden{false};
+        bool selected{false};
+        std::vector<std::size_t> pts; // indices of items in group
+        std::vector<std::size_t> lines;
+        std::vector<std::size_t> vecs;
+    };
+    std::vector<grp_data> grps;
+    std::unordered_map<int, std::uint32_t> grp_index;
+    bool any_selected{false}; // items might be selected (cleared by clear_selection)
+
+    bool pt_is_selected(std::size_t i) const
+    {
+        return pt_selected[i] || grps[pt_style_grp[pt_style[i]]].selected;
+    }
+    bool line_is_selected(std::size_t i) const
+    {
+        return line_selected[i] || grps[line_style_grp[line_style[i]]].selected;
+    }
+    bool vec_is_selected(std::size_t i) const
+    {
+        return vec_selected[i] || grps[vec_style_grp[vec_style[i]]].selected;
+    }
+    void draw_selection(QPainter* qp, Coordsys* cs, const bbox2d& view);
+    std::vector<std::uint32_t> pt_style_grp; // group of each style
+    std::vector<std::uint32_t> line_style_grp;
+    std::vector<std::uint32_t> vec_style_grp;
+
+    std::uint32_t grp_idx(int grp); // dense index (new group if not yet known)
+    std::uint32_t line_style_idx(const ln2d_mark& m);
+    std::uint32_t vec_style_idx(const vec2d_mark& m);
+    bool pt_hidden(std::size_t i) const
+    {
+        return !pt_active[i] || grps[pt_style_grp[pt_style[i]]].hidden;
+    }
+    bool line_hidden(std::size_t i) const
+    {
+        return !line_id[i].active || grps[line_style_grp[line_style[i]]].hidden;
+    }
+    bool vec_hidden(std::size_t i) const
+    {
+        return !vec_id[i].active || grps[vec_style_grp[vec_style[i]]].hidden;
+    }
+    // call fn(kind, index) for all points, lines and vectors with ids in
+    // [first_id, last_id] (marked line vertices: for their line)
+    enum class item_kind { pt, line, vec };
+    template <typename Fn>
+    void for_ids(int first_id, int last_id, Fn fn) const;
+
+    // data for streams (deque: references to the series stay valid)
+    struct stream_item
+    {
+        Ring_series buf;
+        std::uint32_t style; // index of mark in line_styles
+        int id;
+    };
+    std::deque<stream_item> streams;
+    std::vector<double> stream_x; // transformed samples (reused by draw)
+    std::vector<double> stream_y;
+    std::vector<QPointF> stream_pts;
+
+    void draw_streams(QPainter* qp, Coordsys* cs, stream_state* drawn);
+    void draw_stream(QPainter* qp, Coordsys* cs, const stream_item& s,
+                     std::uint64_t from, std::uint64_t& upto, std::vector<double>& x,
+                     std::vector<double>& y, std::vector<QPointF>& pts) const;
 
     // model label (e.g. time stamp description)
     std::string m_label;
+
+    // spatial index per item type for culling of invisible items
+    // (built incrementally by the add_* functions)
+    Point_grid pt_grid; // indexes pt_x and pt_y (no boxes per point)
+    Spatial_grid line_grid;
+    Spatial_grid vec_grid;
+    double max_mark_px{0.0}; // max. extent of marks and pens in pixels
+    std::vector<std::size_t> vis; // indices of visible items (reused)
+
+    bbox2d view_box(Coordsys* cs) const;
+    void update_max_mark_px(const QPen& pen, int nsize);
+
+    // visible items are drawn in runs of the same style to set the painter
+    // state only once per run (the order of the items is kept)
+    std::vector<std::size_t> bucket; // begin of each run in items (reused)
+    template <typename Style_of>
+    void style_runs(const std::vector<std::size_t>& items, Style_of style_of);
+
+    // rendering of lines
+    ln_draw ln_mode{ln_draw::polyline};
+    draw_stats ln_stats;
+    std::vector<QLine> vec_buf;  // transformed vectors of one style (reused)
+    static constexpr int ln_chunk{4096}; // max. vertices per drawPolyline call
+    static constexpr int m4_min_ratio{4}; // decimate x-sorted lines if they have
+                                          // more vertices per pixel column
+
+    // geometry of a line prepared for drawing
+    struct ln_prep
+    {
+        std::vector<QPointF> pts; // transformed (and decimated) vertices
+        std::vector<std::size_t> runs; // begin of each run of finite vertices
+        QPainterPath area;        // for mark_area
+        std::size_t n_vertices{0};
+    };
+    // scratch buffers per thread: transformed x and y columns of a line
+    struct ln_tmp
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+    };
+    std::vector<ln_prep> ln_preps; // per line in vis (reused between draws)
+    std::vector<ln_tmp> ln_tmps;   // per slot of the thread pool
+    static constexpr std::size_t ln_grain{4}; // lines per task of the pool
+
+    void prepare_lns(Coordsys* cs, std::stop_token stop);
+    void prepare_ln(Coordsys* cs, std::size_t i, double ny0, ln_tmp& t,
+                    ln_prep& lp) const;
+    void draw_ln_segments(QPainter* qp, Coordsys* cs, std::size_t i);
+    void draw_ln_polyline(QPainter* qp, const ln_prep& lp);
+    void visible_ln_range(Coordsys* cs, const ln_view& v, std::size_t& first,
+                          std::size_t& last) const;
+    void transform_ln(Coordsys* cs, const ln_view& v, std::size_t first,
+                      std::size_t last, ln_tmp& t) const;
+    void fill_ln_pts(const ln_tmp& t, bool decimate, ln_prep& lp) const;
+    static void m4_decimate(const std::vector<double>& xs, const std::vector<double>& ys,
+                            std::size_t b, std::size_t e, std::vector<QPointF>& pts);
+
+    // rendering of point marks
+    pt_draw pt_mode{pt_draw::sprites};
+    Marker_atlas pt_atlas;
+    std::vector<marker_inst> pt_inst; // marks to be drawn from pt_atlas (reused)
+    std::vector<std::size_t> pt_direct; // visible marks to be drawn w/o atlas
+    std::vector<double> pt_nx;        // transformed coordinates of visible points
+    std::vector<double> pt_ny;        // and marked line vertices (reused)
+    std::vector<std::uint32_t> pt_vis_style; // their styles (no_style: inactive)
+    static constexpr std::uint32_t no_style{UINT32_MAX};
+    static constexpr std::size_t pt_grain{16384}; // points per task of the pool
+
+    // picking: tree of active points and vertices of active lines in scaled axis
+    // coordinates (item index: point index or n_pts + index of line vertex)
+    // (shared by copies of the model, it is not modified after it is built)
+    std::shared_ptr<const pick_index> pick_idx; // tree used by pick
+
+    std::shared_ptr<const pick_index> build_pick_index(axis_scal xscal,
+                                                       axis_scal yscal) const;
+
+    void modify(); // called first by all modifying functions (new version)
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QColor>
+#include <QFont>
+#include <QFontMetrics>
+#include <QPen>
+#include <QString>
+
+#include <cstdint>
+
+// user configurable look of a coordinate system (see Coordsys::set_theme)
+struct cs_theme {
+    QString font_family{"Helvetica"};
+    int notch_font_size{12}; // labels of major notches
+    int label_font_size{14}; // axis labels (bold) and log10 hints
+    int title_font_size{16}; // title (bold)
+
+    QPen axis_pen{QColor(Qt::black), 1, Qt::SolidLine}; // axes, notches and text
+    QPen grid_pen{QColor(Qt::gray), 1, Qt::DotLine};    // helper lines at major notches
+    QPen zoom_pen{QColor(Qt::blue), 2, Qt::SolidLine};  // rectangle of zoom action
+    QPen select_pen{QColor(255, 140, 0, 160), 4, Qt::SolidLine}; // selected items
+};
+
+struct cs_style // theme with fonts and metrics resolved once for painting
+
+// font matching and metrics lookups are done in the constructor only, the draw
+// routines just use the results. A style is not changed after construction:
+// copies of a Coordsys (e.g. for rendering on another thread) share it.
+{
+    explicit cs_style(const cs_theme& t = {});
+
+    cs_theme theme;
+
+    QFont notch_font;
+    QFont label_font;
+    QFont log_font;
+    QFont title_font;
+
+    QFontMetrics notch_fm;
+    QFontMetrics label_fm;
+    QFontMetrics log_fm;
+    QFontMetrics title_fm;
+
+    int log_x_advance; // of the log10 hints
+    int log_y_advance;
+
+    // identifies the style, e.g. for text measured with its fonts
+    std::uint64_t id;
+};
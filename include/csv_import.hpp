@@ -0,0 +1,48 @@
+#pragma once
+
+#include "coordsys_model.hpp"
+
+#include <QString>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// import of columns of numbers from text files (csv, tab or space separated)
+//
+// the text is split into chunks at line ends, which are parsed in parallel on
+// Thread_pool::global() with std::from_chars. Each row gets its own index in
+// the resulting columns, so the chunks can be written independently.
+//
+// empty lines and lines starting with '#' are skipped. Empty fields, fields
+// that are not a number and missing fields are stored as nan, which is drawn
+// as a gap in the line.
+
+enum class csv_header { detect, yes, no };
+
+struct csv_options {
+    char delimiter{0};                     // 0: detect (',', ';', tab or space)
+    csv_header header{csv_header::detect}; // detect: first row is a header if it
+                                           // contains fields that are not numbers
+    int x_col{0};             // column of the x values, -1: row number as x
+    std::vector<int> y_cols;  // columns of the y values (empty: all but x_col)
+};
+
+struct csv_table {
+    std::vector<std::string> names; // column names (header or "col <n>")
+    std::vector<double> x;
+    std::vector<std::vector<double>> y; // same order as selected y columns
+    std::vector<int> y_cols;            // selected y columns
+};
+
+// parse text (e.g. a memory mapped file)
+csv_table parse_csv(std::string_view text, const csv_options& opt = {});
+
+// map file into memory and add one line per y column to cm (the model takes
+// over the parsed columns, the x column is shared by all lines), returns the
+// ids of the lines
+// throws std::runtime_error if the file can't be read
+std::vector<int> import_csv(Coordsys_model& cm, const QString& file_name,
+                            const csv_options& opt = {},
+                            const ln2d_mark& m = ln2d_mark_default);
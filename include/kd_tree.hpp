@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// item of a Kd_tree: position and index in the owner's containers
+struct kd_item {
+    double x{0.0}, y{0.0};
+    std::size_t idx{0};
+};
+
+class Kd_tree // 2d tree for nearest neighbour queries (e.g. picking with the mouse)
+
+// the tree is implicit: the items are reordered so that the median of each
+// range (alternately in x and y) is in its middle, no nodes are allocated.
+// Small ranges at the bottom are scanned linearly.
+//
+// the metric is chosen per query: d^2 = (wx*dx)^2 + (wy*dy)^2, i.e. the tree can
+// be built once in model coordinates and queried in pixels for any zoom level
+{
+  public:
+
+    // build the tree from items (non-finite items are dropped), the top levels
+    // are split sequentially, the subtrees below in parallel
+    void build(std::vector<kd_item> new_items);
+    void clear() { items.clear(); }
+
+    std::size_t size() const { return items.size(); }
+
+    // item nearest to (qx, qy) within distance r, false if there is none
+    bool nearest(double qx, double qy, double wx, double wy, double r, kd_item& found,
+                 double& d) const;
+
+  private:
+
+    std::vector<kd_item> items;
+
+    static constexpr std::size_t leaf_size{8}; // ranges scanned linearly
+
+    void split(std::size_t b, std::size_t e, int depth); // median to the middle
+    void build_range(std::size_t b, std::size_t e, int depth);
+
+    struct query {
+        double qx, qy, wx, wy;
+        double best_d2;
+        std::size_t best;
+    };
+    void nearest_range(std::size_t b, std::size_t e, int depth, query& q) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QFont>
+#include <QStaticText>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// prepared label with the metrics needed to place it
+struct label_text {
+    QStaticText text; // laid out once, drawn with drawStaticText
+    int advance{0};   // horizontal advance of the text
+    int ascent{0};    // of the font (drawStaticText places the top left corner)
+};
+
+class Label_cache // number labels (e.g. of axis notches) prepared as QStaticText
+
+// labels are kept across frames, so text shaping and measuring are done only
+// once per (value, format, precision, font). The labels used least recently are
+// dropped if more than capacity labels are cached.
+//
+// may be used from several threads (copies of a Coordsys share the cache of
+// their axes), labels are returned by value (QStaticText is implicitly shared)
+{
+  public:
+
+    explicit Label_cache(std::size_t capacity = 512);
+
+    // label of QString::number(v, format, precision) in font
+    label_text number(double v, const QFont& font, char format = 'g', int precision = 6);
+
+    std::size_t size() const;
+
+  private:
+
+    struct key {
+        std::uint64_t v; // bit pattern of value
+        char format;
+        int precision;
+        int font; // index in fonts
+
+        bool operator==(const key&) const = default;
+    };
+    struct key_hash {
+        std::size_t operator()(const key& k) const;
+    };
+    struct entry {
+        label_text label;
+        std::list<key>::iterator lru_pos;
+    };
+
+    mutable std::mutex mtx;
+    std::size_t capacity;
+    std::vector<QFont> fonts; // distinct fonts used (just a few)
+    std::unordered_map<key, entry, key_hash> labels;
+    std::list<key> lru; // most recently used first
+
+    int font_idx(const QFont& font);
+};
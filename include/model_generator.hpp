@@ -0,0 +1,81 @@
+#pragma once
+
+#include "coordsys_model.hpp"
+#include "model_source.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Model_generator : public Model_source // frames built on demand by a callable
+
+// gen(i) builds the model of frame i. It is called lazily: the frame requested
+// by frame() is built in the calling thread (if it is not cached or already
+// being built), the frame requested by try_frame() is built by a worker thread
+// before anything else, the neighbours of the frame requested last are
+// prefetched by worker threads. At most capacity frames are cached, the frame used least
+// recently is dropped first (frames still in use stay alive as long as they
+// are used).
+//
+// ATTENTION: gen is called concurrently from several threads
+{
+  public:
+
+    using gen_fn = std::function<Coordsys_model(std::size_t)>;
+
+    // prefetch: number of frames before and after the current frame
+    // (capacity is increased to hold the current frame, its neighbours and the
+    // frames being prefetched)
+    Model_generator(std::size_t n_frames, gen_fn gen, std::size_t capacity = 16,
+                    std::size_t prefetch = 2, unsigned n_workers = 2);
+    ~Model_generator();
+
+    Model_generator(const Model_generator&) = delete;
+    Model_generator& operator=(const Model_generator&) = delete;
+
+    std::size_t size() const override { return n_frames; }
+    std::shared_ptr<Coordsys_model> frame(std::size_t idx) override;
+    std::shared_ptr<Coordsys_model> try_frame(std::size_t idx) override;
+    void on_frame_ready(std::function<void(std::size_t)> fn) override;
+
+    std::size_t n_cached() const;
+
+  private:
+
+    struct entry {
+        std::shared_ptr<Coordsys_model> cm;
+        std::list<std::size_t>::iterator lru_pos;
+    };
+
+    std::size_t n_frames;
+    gen_fn gen;
+    std::size_t capacity;
+    std::size_t prefetch;
+
+    mutable std::mutex mtx;
+    std::condition_variable_any cv;      // new prefetch requests
+    std::condition_variable_any cv_done; // frame finished by a worker
+    std::unordered_map<std::size_t, entry> cache;
+    std::list<std::size_t> lru;  // most recently used first
+    std::set<std::size_t> building;
+    std::deque<std::size_t> wanted; // frames to prefetch (most important first)
+    std::set<std::size_t> failed;   // gen threw on a worker (reported by frame())
+    std::size_t requested{SIZE_MAX}; // frame of try_frame() not yet available
+    std::function<void(std::size_t)> ready_fn; // called when requested is built
+
+    std::vector<std::jthread> workers; // last member: started after all others
+
+    void insert(std::size_t idx, std::shared_ptr<Coordsys_model> cm); // mtx locked
+    void request_neighbours(std::size_t idx);                          // mtx locked
+    void run(std::stop_token st);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "coordsys_model.hpp"
+#include "model_source.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class Model_sequence : public Model_source // frames of lines with common x values
+
+// the x values and the marks of the lines are stored once for all frames, each
+// frame only keeps its y values as compressed deltas to the previous frame:
+//
+// - q > 0: y values are quantized to multiples of q (error <= q/2), a frame
+//   stores the differences of the integers to the previous frame
+// - q = 0: lossless, a frame stores the xor of the bit patterns of the doubles
+//   (pays off if most values are unchanged between frames; smoothly changing
+//   values should be quantized, e.g. to a fraction of a pixel)
+//
+// small deltas are encoded with few bytes (varint). Every key_interval frames a
+// key frame is stored (deltas to the previous vertex of the same frame), so a
+// frame can be reached w/o decoding all frames before it. Moving forward by one
+// frame (e.g. with the slider) decodes only that frame.
+//
+// frames are materialized as models with views of the x values and of their
+// own decoded y values (nan stays nan and is drawn as a gap).
+{
+  public:
+
+    // x: common x values of all lines, n_lines: number of lines per frame
+    Model_sequence(std::vector<double> x, int n_lines = 1, double q = 0.0,
+                   std::size_t key_interval = 64);
+
+    void set_mark(int line, const ln2d_mark& m); // for all frames
+
+    // append frame with the y values of all lines (line by line, i.e. n_lines
+    // times x.size() values), throws std::runtime_error if the size differs
+    void add_frame(std::span<const double> y, const std::string& label = {});
+
+    std::size_t size() const override { return labels.size(); }
+    std::shared_ptr<Coordsys_model> frame(std::size_t idx) override;
+
+    std::size_t bytes() const; // memory used for the frames (w/o the x values)
+
+  private:
+
+    std::shared_ptr<const std::vector<double>> x;
+    int n_lines;
+    double q;
+    std::size_t key_interval;
+    std::vector<ln2d_mark> marks;
+    std::vector<std::string> labels;
+
+    std::vector<std::uint8_t> data; // varint encoded deltas of all frames
+    std::vector<std::size_t> frame_pos; // start of frame in data
+
+    std::vector<std::uint64_t> last_codes; // last frame added (for the deltas)
+    std::vector<std::uint64_t> dec_codes;  // last frame decoded
+    std::size_t dec_idx{SIZE_MAX};         // index of last frame decoded
+
+    std::uint64_t encode(double y) const;
+    double decode(std::uint64_t c) const;
+    std::uint64_t delta(std::uint64_t c, std::uint64_t ref) const;
+    std::uint64_t undelta(std::uint64_t d, std::uint64_t ref) const;
+    void decode_frame(std::size_t idx); // dec_codes of idx from dec_idx or key frame
+};
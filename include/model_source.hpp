@@ -0,0 +1,36 @@
+#pragma once
+
+#include "coordsys_model.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+class Model_source // sequence of models (frames) selected with the slider of w_Cs_view
+
+// in contrast to a vector of models the frames need not exist all at the same
+// time: a source may build them on demand. frame() is called in the gui thread,
+// the returned model is kept alive by its users as long as it is drawn, so
+// a source is free to hand out a new model for each call.
+{
+  public:
+
+    virtual ~Model_source() = default;
+
+    virtual std::size_t size() const = 0; // number of frames
+
+    // model of frame idx (0 <= idx < size())
+    virtual std::shared_ptr<Coordsys_model> frame(std::size_t idx) = 0;
+
+    // non-blocking variant of frame(): nullptr if frame idx is not available
+    // yet (a source building frames in the background starts building it and
+    // calls the function set by on_frame_ready when it is finished)
+    virtual std::shared_ptr<Coordsys_model> try_frame(std::size_t idx)
+    {
+        return frame(idx);
+    }
+
+    // fn is called from a worker thread with the index of a frame requested by
+    // try_frame when it is finished (an empty fn removes it)
+    virtual void on_frame_ready(std::function<void(std::size_t)> fn) { (void)fn; }
+};
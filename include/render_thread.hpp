@@ -0,0 +1,97 @@
+#pragma once
+
+#include "coordsys.hpp"
+#include "coordsys_model.hpp"
+
+#include <QImage>
+#include <QSize>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+// identification of a rendered frame: a frame has to be re-rendered if any of
+// the coordsys, the model (incl. clearing of its streams) or the widget geometry
+// changed
+struct frame_key {
+    std::uint64_t cs_version{0};
+    const Coordsys_model* cm{nullptr};
+    std::uint64_t cm_version{0};
+    std::uint64_t cm_streams{0}; // Coordsys_model::streams_epoch()
+    QSize size;
+    qreal dpr{0.0};
+
+    bool operator==(const frame_key&) const = default;
+};
+
+class Render_thread // renders coordsys and model into images on a worker thread
+
+// request() hands over a copy of the coordsys (the model is used by pointer)
+// and returns immediately. A running render is finished even if a newer frame
+// is requested meanwhile (it is returned with its own key), of the requests
+// arriving in the meantime only the latest one is rendered next. on_frame is
+// called on the worker thread each time a frame is finished, take_frame()
+// returns it. cancel() stops a running render.
+//
+// ATTENTION: the model must not be modified or drawn elsewhere while a frame is
+// requested and not yet finished (use wait_idle() before changing it)
+{
+  public:
+
+    explicit Render_thread(std::function<void()> on_frame);
+    ~Render_thread();
+
+    // keep is held until the frame is finished (e.g. owner of a model that is
+    // materialized on demand and might be replaced in the meantime)
+    void request(const Coordsys& cs, Coordsys_model* cm, const frame_key& key,
+                 std::shared_ptr<const void> keep = {});
+
+    // latest finished frame (if a new one arrived since the last call) with the
+    // state of the streams of the model drawn into it
+    bool take_frame(QImage& frame, frame_key& key,
+                    Coordsys_model::stream_state& streams);
+
+    // key of the frame requested last
+    std::optional<frame_key> requested() const;
+
+    // block until all requested frames are finished or cancelled
+    void wait_idle();
+
+    // drop the requested frame, cancel the running one and wait for the worker
+    // (e.g. before the model is modified)
+    void cancel();
+
+  private:
+
+    struct job {
+        Coordsys cs;
+        Coordsys_model* cm;
+        frame_key key;
+        std::shared_ptr<const void> keep;
+    };
+
+    std::function<void()> on_frame;
+
+    mutable std::mutex mtx;
+    std::condition_variable_any cv;
+    std::condition_variable_any cv_idle;
+    std::optional<job> pending;          // next job to be rendered
+    std::optional<frame_key> last_key;   // key of last requested job
+    std::stop_source current_stop;       // cancels the job being rendered
+    bool rendering{false};
+    QImage frame_done;
+    frame_key frame_done_key;
+    Coordsys_model::stream_state frame_done_streams;
+    bool has_frame{false};
+
+    std::jthread worker; // last member: started after all others are set up
+
+    void run(std::stop_token st);
+    static QImage render(job& j, std::stop_token stop,
+                         Coordsys_model::stream_state& streams);
+};
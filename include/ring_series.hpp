@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class Ring_series // fixed capacity ring buffer of (x, y) samples for streaming
+
+// append is O(1) and overwrites the oldest samples when the buffer is full.
+// all samples ever appended are counted: sample k (k = 0, 1, 2, ...) is kept as
+// long as k >= total() - capacity(), which allows readers to ask for samples
+// appended since a former call (incremental drawing). clear() drops all samples
+// but keeps counting, so former totals stay valid: first() tells readers that
+// samples they copied before have been cleared.
+//
+// all functions may be called concurrently from different threads (e.g.
+// appending from an acquisition thread while drawing in the gui thread)
+{
+  public:
+
+    explicit Ring_series(std::size_t capacity);
+    Ring_series(const Ring_series& other);
+    Ring_series& operator=(const Ring_series& other);
+
+    void append(double x, double y);
+    void append(std::span<const double> x, std::span<const double> y);
+    void clear();
+
+    std::size_t capacity() const { return cap; }
+    std::size_t size() const;
+    std::uint64_t total() const; // number of samples appended since creation
+    std::uint64_t first() const; // total() at the last clear() (0 if never cleared)
+
+    // x value of the latest sample (false if empty)
+    bool last_x(double& x) const;
+
+    // copy samples [from, total()) that are still available into the columns
+    // x and y (replacing their content), returns the index of the first sample
+    // copied (> from if samples have been overwritten in the meantime)
+    std::uint64_t copy_since(std::uint64_t from, std::vector<double>& x,
+                             std::vector<double>& y) const;
+
+  private:
+
+    mutable std::mutex mtx;
+    std::size_t cap;
+    std::vector<double> xs; // ring storage, sample k at index k % cap
+    std::vector<double> ys;
+    std::uint64_t n_total{0};
+    std::uint64_t n_first{0}; // samples before were dropped by clear()
+
+    void push(double x, double y);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// axis aligned bounding box in (unscaled) model coordinates
+struct bbox2d {
+    double xmin{0.0}, xmax{0.0};
+    double ymin{0.0}, ymax{0.0};
+
+    bool intersects(const bbox2d& b) const
+    {
+        return xmin <= b.xmax && b.xmin <= xmax && ymin <= b.ymax && b.ymin <= ymax;
+    }
+    bool contains(const bbox2d& b) const
+    {
+        return xmin <= b.xmin && b.xmax <= xmax && ymin <= b.ymin && b.ymax <= ymax;
+    }
+};
+
+class Spatial_grid // uniform grid over the bounding boxes of model items
+                   // for culling of items outside of the visible range
+
+// items are identified by their index in the model container and have to be
+// inserted in the order of their index (0, 1, 2, ...)
+//
+// extent and resolution of the grid adapt while items are inserted: the grid is
+// rebuilt (amortized O(1) per item) when an item falls outside of the current
+// extent or when the number of items per cell grows too large
+{
+  public:
+
+    void insert(std::size_t idx, const bbox2d& b);
+    void clear();
+
+    // indices of all items intersecting view in ascending order
+    // (costs are proportional to the number of items in the covered cells)
+    void query(const bbox2d& view, std::vector<std::size_t>& result) const;
+
+    std::size_t size() const { return box.size(); }
+    const bbox2d& item_box(std::size_t idx) const { return box[idx]; }
+
+  private:
+
+    std::vector<bbox2d> box; // bounding box of each item
+
+    bbox2d ext;          // extent covered by the grid
+    bool has_ext{false}; // ext is valid (at least one finite item)
+    int nx{0}, ny{0};    // number of cells in x and y direction
+    std::vector<std::vector<std::size_t>> cells; // items per cell (row major)
+    std::vector<std::size_t> big; // items covering too many cells, and items
+                                  // with non-finite boxes
+
+    // marks to avoid duplicates for items in several cells during query
+    mutable std::vector<unsigned> stamp;
+    mutable unsigned qstamp{0};
+
+    static constexpr int n_start{16};       // initial cells per direction
+    static constexpr int n_max{512};        // max. cells per direction
+    static constexpr int items_per_cell{8}; // refine grid above this average
+    static constexpr int max_item_cells{64}; // larger items are kept in big
+
+    void rebuild(const bbox2d& new_ext, int new_n);
+    void add_to_cells(std::size_t idx);
+    int cell_x(double x) const;
+    int cell_y(double y) const;
+};
+
+class Point_grid // uniform grid over points for culling of points outside of the
+                 // visible range
+
+// like Spatial_grid, but the coordinates stay in the columns of the owner (x and
+// y are passed to insert and query, they have to hold all points inserted), no
+// boxes are stored per point. A point is in exactly one cell, so no marks are
+// needed to avoid duplicates, and the cells hold 32 bit indices.
+{
+  public:
+
+    // x and y hold the coordinates of points 0 .. idx
+    void insert(std::size_t idx, std::span<const double> x, std::span<const double> y);
+    void clear();
+
+    // indices of all points within view in ascending order
+    // (costs are proportional to the number of points in the covered cells)
+    void query(const bbox2d& view, std::span<const double> x, std::span<const double> y,
+               std::vector<std::size_t>& result) const;
+
+    std::size_t size() const { return n; }
+
+  private:
+
+    std::size_t n{0};    // number of points inserted
+    bbox2d ext;          // extent covered by the grid
+    bool has_ext{false}; // ext is valid (at least one finite point)
+    int nx{0}, ny{0};    // number of cells in x and y direction
+    std::vector<std::vector<std::uint32_t>> cells; // points per cell (row major)
+    std::vector<std::uint32_t> big; // points with non-finite coordinates
+
+    static constexpr int n_start{16};       // initial cells per direction
+    static constexpr int n_max{512};        // max. cells per direction
+    static constexpr int items_per_cell{8}; // refine grid above this average
+
+    void rebuild(std::span<const double> x, std::span<const double> y,
+                 const bbox2d& new_ext, int new_n);
+    void add_to_cells(std::size_t idx, double x, double y);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QColor>
+#include <QPen>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional> // std::hash
+#include <unordered_map>
+#include <vector>
+
+// combine hash value v into h
+inline void hash_combine(std::size_t& h, std::size_t v)
+{
+    h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+}
+
+// hash of the properties of a pen that are used for drawing in the model
+inline std::size_t pen_hash(const QPen& pen)
+{
+    std::size_t h = std::hash<QRgb>{}(pen.color().rgba());
+    hash_combine(h, std::hash<qreal>{}(pen.widthF()));
+    hash_combine(h, std::hash<int>{}(pen.style()));
+    hash_combine(h, std::hash<int>{}(pen.capStyle()));
+    hash_combine(h, std::hash<int>{}(pen.joinStyle()));
+    return h;
+}
+
+template <typename T, typename Hash>
+class Style_table // deduplicated table of styles (e.g. marks of items)
+
+// each distinct style is stored once and referred to by its index, which stays
+// valid until clear() is called
+// T requires operator==, Hash a hash function object for T
+{
+  public:
+
+    // index of style s (added to the table on first use)
+    std::uint32_t intern(const T& s)
+    {
+        auto it = idx.find(s);
+        if (it != idx.end()) return it->second;
+
+        std::uint32_t i = styles.size();
+        styles.push_back(s);
+        idx.emplace(s, i);
+        return i;
+    }
+
+    const T& operator[](std::uint32_t i) const { return styles[i]; }
+    std::size_t size() const { return styles.size(); }
+
+    void clear()
+    {
+        styles.clear();
+        idx.clear();
+    }
+
+  private:
+
+    std::vector<T> styles;
+    std::unordered_map<T, std::uint32_t, Hash> idx;
+};
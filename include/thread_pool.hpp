@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Thread_pool // fixed set of worker threads for data parallel loops
+
+// parallel_for splits [0, n) into chunks, which are distributed over per-thread
+// queues. Each thread works on its own queue and steals chunks from the other
+// queues when it runs out of work (work stealing), so uneven chunks (e.g. lines
+// of very different length) are balanced automatically.
+//
+// the calling thread takes part in the work as slot 0, workers use the slots
+// 1 .. size()-1. The slot can be used to index per-thread scratch buffers.
+//
+// calls from different threads are executed one after the other, nested calls
+// from inside of fn run sequentially on the calling thread.
+{
+  public:
+
+    using chunk_fn = std::function<void(std::size_t begin, std::size_t end, unsigned slot)>;
+
+    explicit Thread_pool(unsigned n_threads = std::thread::hardware_concurrency());
+    ~Thread_pool();
+
+    Thread_pool(const Thread_pool&) = delete;
+    Thread_pool& operator=(const Thread_pool&) = delete;
+
+    // number of threads incl. the calling thread (= number of slots)
+    unsigned size() const { return workers.size() + 1; }
+
+    // call fn for all chunks of at most grain items in [0, n) and return when all
+    // chunks are done (exceptions thrown by fn are rethrown here)
+    void parallel_for(std::size_t n, std::size_t grain, const chunk_fn& fn);
+
+    // pool shared by all users in the application
+    static Thread_pool& global();
+
+  private:
+
+    struct chunk
+    {
+        std::size_t begin, end;
+    };
+    struct chunk_queue
+    {
+        std::mutex mtx;
+        std::deque<chunk> q;
+    };
+
+    std::vector<std::unique_ptr<chunk_queue>> queues; // one per slot
+    std::vector<std::thread> workers;
+
+    std::mutex submit_mtx; // one parallel_for at a time
+
+    std::mutex mtx; // protects the state of the current job below
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+    const chunk_fn* job{nullptr};
+    std::uint64_t job_gen{0};   // incremented for each job
+    unsigned busy{0};           // workers currently working on job
+    std::atomic<std::size_t> pending{0}; // chunks of job not finished yet
+    std::exception_ptr error;   // first exception thrown by job
+    bool stop{false};
+
+    void run(unsigned slot);
+    void work(unsigned slot, const chunk_fn& fn);
+    bool pop(unsigned slot, chunk& c);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "coordsys.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+class View_history // bounded undo/redo stack of view states
+
+// each step stores a view_state only (a few dozen bytes, independent of labels,
+// titles and models), pushing and undoing are constant in time. If more than
+// max_steps undo steps are stored, the oldest ones are dropped.
+//
+// steps of the same kind (kind != 0, e.g. consecutive wheel or pan steps) are
+// coalesced into one step if they follow each other within coalesce_window:
+// undo then returns to the view before the first of them
+{
+  public:
+
+    using clock = std::chrono::steady_clock;
+
+    explicit View_history(std::size_t max_steps = 1000,
+                          clock::duration coalesce_window = std::chrono::milliseconds(500));
+
+    // vs: view before a change of the given kind (drops all redo steps)
+    void push(const view_state& vs, int kind = 0);
+
+    // current: view to be replaced, returned by the opposite operation
+    // (false: nothing to undo or redo)
+    bool undo(const view_state& current, view_state& previous);
+    bool redo(const view_state& current, view_state& next);
+
+    void clear();
+    void set_max_steps(std::size_t n); // drops the oldest undo steps if required
+    void set_coalesce_window(clock::duration w) { window = w; }
+
+    std::size_t undo_steps() const { return undo_stack.size(); }
+    std::size_t redo_steps() const { return redo_stack.size(); }
+    std::size_t max_steps() const { return max_n; }
+    std::size_t bytes() const; // memory used by the stored steps
+
+  private:
+
+    std::deque<view_state> undo_stack; // oldest first
+    std::vector<view_state> redo_stack; // next redo step last
+    std::size_t max_n;
+    clock::duration window;
+
+    int last_kind{0}; // kind and time of the last push (for coalescing)
+    clock::time_point last_time;
+};
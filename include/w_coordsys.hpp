@@ -2,11 +2,21 @@
 
 #include "coordsys.hpp"
 #include "coordsys_model.hpp"
+#include "model_source.hpp"
+#include "render_thread.hpp"
+#include "view_history.hpp"
 
+#include <QImage>
 #include <QPainter>
+#include <QTimer>
 #include <QWidget>
 #include <QtWidgets>
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
 // pan, zoom and wheel_zoom actions
 enum class pz_action { none, pan, zoom, wheel_zoom };
 
@@ -16,6 +26,15 @@ enum class pz_action { none, pan, zoom, wheel_zoom };
 // y_only:  restrict pan/zoom to y axis
 enum class pz_mode { x_and_y, x_only, y_only };
 
+// pan and wheel events received and applied to the coordsys: events arriving
+// faster than the display refresh rate are merged
+struct input_stats {
+    std::uint64_t events{0};  // pan and wheel events received
+    std::uint64_t applied{0}; // changes of the view (at most one per frame)
+
+    std::uint64_t merged() const { return events - applied; }
+};
+
 class w_Coordsys : public QWidget {
     Q_OBJECT
 
@@ -24,14 +43,62 @@ class w_Coordsys : public QWidget {
     w_Coordsys(Coordsys* cs, Coordsys_model* cm, QWidget* parent = nullptr);
     w_Coordsys(Coordsys* cs, const std::vector<Coordsys_model*> vm,
                QWidget* parent = nullptr);
+    // models of frames built on demand by source (e.g. Model_sequence)
+    w_Coordsys(Coordsys* cs, std::shared_ptr<Model_source> source,
+               QWidget* parent = nullptr);
+    ~w_Coordsys();
 
     // ATTENTION: caller responsible that model ptr vm is valid during life time
 
+    // render coordsys and model on a worker thread (off by default: opt in only
+    // if the models are not modified after construction of the widget)
+    // the widget shows the latest finished frame and stays responsive
+    // ATTENTION: models must not be modified while asynchronous rendering is on
+    // (other than with edit_model)
+    void set_async_render(bool on);
+
+    // new samples of streams of the model are added to the shown frame
+    // (checked with the refresh rate of the display); if width > 0 the x axis
+    // follows the latest sample with a window of width (in scaled values)
+    void set_scroll_window(double width);
+
+    // items of the model within tol pixels of the mouse are reported by
+    // itemHovered (tol = 0 switches hover picking off)
+    void set_pick_tolerance(int tol) { pick_tol = tol; }
+
+    // modify the current model (e.g. show or hide groups of items): a frame of
+    // the model being rendered asynchronously is cancelled before fn is called,
+    // the widget is updated afterwards
+    void edit_model(const std::function<void(Coordsys_model&)>& fn);
+
+    // undo/redo steps of pan and zoom (e.g. to set the max. number of steps)
+    View_history& history() { return cs_history; }
+
+    // label of the model shown
+    std::string model_label() const { return cm->label(); }
+
+    const input_stats& input_statistics() const { return in_stats; }
+    void reset_input_statistics() { in_stats = input_stats{}; }
+
   protected:
 
     void resizeEvent(QResizeEvent* event);
     void paintEvent(QPaintEvent* event);
-    void draw(QPainter* qp);
+    void draw(QPainter* qp);           // coordsys and model
+    void draw_zoom_rect(QPainter* qp); // overlay during zoom
+    void update_layer();   // synchronous rendering
+    void present_frame();  // asynchronous rendering
+    frame_key current_key();
+    void draw_stream_increments(); // new samples of streams into layer
+    void init();                   // common part of the constructors
+    QRect cs_area() const;         // active area of coordsys on the widget
+    void scroll_plot();            // pan: move plot, render exposed strips
+    bool plot_matches();           // plot shows the current view (up to a shift)
+    void plot_from_layer();        // start plot with layer (if current)
+    void draw_plot_part(QPainter* qp, const QRect& r, // grid and model in r
+                        Coordsys_model::stream_state* drawn = nullptr);
+    void end_scroll_plot();        // back to full frames
+    void model_switched();         // cm was replaced by another model
     void keyPressEvent(QKeyEvent* event);
     void keyReleaseEvent(QKeyEvent* event);
     void mousePressEvent(QMouseEvent* event);
@@ -39,18 +106,35 @@ class w_Coordsys : public QWidget {
     void mouseMoveEvent(QMouseEvent* event);
     void wheelEvent(QWheelEvent* event);
 
-    void push_to_history();  // for undo
+    // for undo, steps of the same kind (pan, wheel_zoom) following each other
+    // quickly are coalesced
+    // pan and wheel input: applied at once if no view change was applied in
+    // the current frame, otherwise accumulated until the frame is over
+    void queue_input();
+    void apply_input(); // pending pan and wheel zoom (e.g. before other changes)
+
+    void push_to_history(pz_action kind = pz_action::none);
     void pop_from_history(); // undo
+    void redo_history();     // redo
 
   private slots:
     void switch_to_model(int);
+    void frame_ready(); // frame of source selected last was built
+    void check_streams();
+    void input_frame(); // end of a frame of input
 
   signals:
     void mouseMoved(bool hot, mouse_pos_t mouse_pos);
+    void itemHovered(bool found, pick_result item);
     void modeChanged(pz_action action, pz_mode mode);
-    void undoChanged(int undo_steps);
+    void undoChanged(int undo_steps, int redo_steps);
     void labelChanged(std::string new_label);
     void scalingChanged(axis_scal xscal, axis_scal yscal);
+    // the model selected last by switch_to_model is shown (e.g. for playback)
+    void framePresented();
+    // building the model selected by switch_to_model failed (the current model
+    // is kept)
+    void frameFailed(int idx, std::string error);
 
   private:
 
@@ -59,7 +143,42 @@ class w_Coordsys : public QWidget {
     std::vector<Coordsys_model*> vm;  // vector of models (owned externally)
                                       // that might be switched between
                                       // in case of several models
-    std::vector<Coordsys> cs_history; // history of coordinate-systems (for undo)
+    std::shared_ptr<Model_source> source; // alternative to vm
+    std::shared_ptr<Coordsys_model> cm_hold; // owner of cm if taken from source
+    int frame_wanted{-1}; // frame of source selected, but not yet built
+    View_history cs_history; // views of the coordinate system (for undo/redo)
+
+    // retained render layer with output of cs->draw and cm->draw
+    // (only re-rendered if the coordsys, the model or the widget changed)
+    QImage layer;
+    frame_key layer_id;
+    std::unique_ptr<Render_thread> renderer; // for asynchronous rendering
+    Coordsys_model::stream_state layer_streams; // samples of streams in layer
+    bool switch_pending{false}; // switched model not yet shown
+
+    // during pan (and while the scroll window follows the streams) the plot area
+    // (grid and model) of the previous paint is moved by the pan distance and
+    // only the strips exposed are rendered (the mapping to the paint device is
+    // affine in scaled values, i.e. a pan is a shift)
+    QImage plot, plot_back;  // plot area only (transparent outside)
+    QRect plot_valid;        // part of plot showing plot_view
+    view_state plot_view;
+    frame_key plot_key;      // of the view the plot was rendered for
+    Coordsys_model::stream_state plot_streams; // samples of streams in plot
+    bool stream_scroll{false}; // scroll window moved the view last
+
+    QTimer stream_timer; // polls the streams for new samples
+
+    // accumulated input (see queue_input)
+    QTimer input_timer;            // runs for one frame after a view change
+    int pan_dnx{0}, pan_dny{0};    // pending pan [pixels]
+    double wheel_scale{1.0};       // pending wheel zoom factor
+    int wheel_nx{0}, wheel_ny{0};  // center of wheel zoom
+    bool input_pending{false};
+    input_stats in_stats;
+    double scroll_width{0.0};
+
+    int pick_tol{5}; // max. distance of hovered items [pixels]
 
     // mouse status
     int m_nx{0};                         // x-position of mouse in widget
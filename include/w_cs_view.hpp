@@ -2,13 +2,19 @@
 
 #include "coordsys.hpp"
 #include "coordsys_model.hpp"
+#include "model_source.hpp"
 #include "w_coordsys.hpp"
 #include "w_statusbar.hpp"
 
+#include <QElapsedTimer>
 #include <QPainter>
+#include <QTimer>
 #include <QWidget>
 #include <QtWidgets>
 
+#include <memory>
+#include <string>
+
 class w_Cs_view : public QWidget
 {
     Q_OBJECT
@@ -18,14 +24,53 @@ class w_Cs_view : public QWidget
     w_Cs_view(Coordsys* cs, Coordsys_model* cm, QWidget* parent = nullptr);
     w_Cs_view(Coordsys* cs, const std::vector<Coordsys_model*> vm,
               QWidget* parent = nullptr);
+    w_Cs_view(Coordsys* cs, std::shared_ptr<Model_source> source,
+              QWidget* parent = nullptr);
 
     // ATTENTION: caller is responsible that model ptr is valid during life time
 
+    // widget showing coordsys and model (e.g. to switch on asynchronous rendering)
+    w_Coordsys* coordsys_widget() { return wcs; }
+
+  public slots:
+
+    // play the models of the slider with fps frames per second (multi model
+    // case only); the next model is selected when the current one is shown, so
+    // models are skipped (counted as dropped) if rendering falls behind
+    void play(double fps = 25.0);
+    void stop();
+
+  signals:
+    void playbackChanged(bool playing, double fps, int dropped);
+
+  private slots:
+    void toggle_playback();
+    void advance_playback(); // select the model due at the current time
+    void on_framePresented();
+    void on_frameFailed(int idx, std::string error);
+
   private:
 
+    // status bar and slider to select one of n_models
+    void setup_with_slider(Coordsys* cs, int n_models);
+    // status bar shows the state of wcs
+    void link_statusbar(Coordsys* cs);
+
     w_Coordsys* wcs;
     w_Statusbar* wsb;
-    QSlider* slider;
+    QSlider* slider{nullptr};
+    QToolButton* play_button{nullptr};
+
+    // playback
+    QTimer play_timer;         // fires when the next model is due
+    QElapsedTimer play_clock;  // time since start of playback
+    QElapsedTimer stat_clock;  // time since last fps report
+    double play_fps{25.0};
+    int play_first{0};         // model shown at start of playback
+    int play_dropped{0};       // models skipped during playback
+    int stat_frames{0};        // models shown since last fps report
+    bool playing{false};
+    bool frame_pending{false}; // model selected, but not yet shown
 
     QGroupBox* w1; // vertical box of CS-widget and slider
 };
@@ -26,17 +26,24 @@ class w_Statusbar : public QWidget {
     // mouse within (min...max) (true) or not (false) cs area, current position is
     // x, y
     void on_mouseMoved(bool hot, mouse_pos_t mouse_pos);
+    // item of the model under the mouse (if found)
+    void on_itemHovered(bool found, pick_result item);
     void on_modelChanged(int step);
     void on_modeChanged(pz_action action, pz_mode mode);
-    void on_undoChanged(int undo_steps);
+    void on_undoChanged(int undo_steps, int redo_steps);
     void on_labelChanged(std::string label);
     void on_scalingChanged(axis_scal xscal, axis_scal yscal);
+    void on_playbackChanged(bool playing, double fps, int dropped);
 
   private:
 
     int w_width;
     const int w_height{20};
 
+    // resolved once (not on each paint)
+    const QFont font{"Helvetica", 12, QFont::Normal};
+    const QFontMetrics fm{font};
+
     // data to be displayed in status bar
 
     // mouse position within coordsys
@@ -44,12 +51,21 @@ class w_Statusbar : public QWidget {
     int m_nx, m_ny;  // mouse position in device coordinates
     double m_x, m_y; // mouse position in cs
 
+    // item under the mouse
+    bool m_item_found{false};
+    pick_result m_item;
+
     // model step (default: show first step)
     int m_step{0};
 
     // model label
     std::string m_label{};
 
+    // playback of models (achieved frame rate and number of skipped models)
+    bool m_playing{false};
+    double m_fps{0.0};
+    int m_dropped{0};
+
     // pan and zoom action
     pz_action m_action{pz_action::none};
 
@@ -57,8 +73,9 @@ class w_Statusbar : public QWidget {
     // (x_and_y: no restriction)
     pz_mode m_mode{pz_mode::x_and_y};
 
-    // number of undo steps available
+    // number of undo and redo steps available
     int m_undo_steps{0};
+    int m_redo_steps{0};
 
     // axis scaling
     axis_scal m_xscaling{axis_scal::linear};
@@ -0,0 +1,379 @@
+#include "axis_kernels.hpp"
+
+#include <cfloat> // DBL_MIN, DBL_MAX
+#include <cmath>  // std::log10, std::pow
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AXIS_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> // __cpuid, __cpuidex, _xgetbv
+#endif
+#endif
+
+// MSVC allows to use the intrinsics without compiling the whole translation unit
+// for the target, gcc and clang require the target attribute per function
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AXIS_TARGET_AVX2
+#else
+#define AXIS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// constants for log10 and 10^x
+static constexpr double c_ln2 = 0.69314718055994530942;
+static constexpr double c_log10e = 0.43429448190325182765;
+static constexpr double c_log2_10 = 3.32192809488736234787;
+static constexpr double c_sqrt2 = 1.41421356237309504880;
+
+// ln(m) = 2f * (1 + f^2/3 + f^4/5 + ... + f^14/15) with f = (m-1)/(m+1)
+// for m in [sqrt(0.5), sqrt(2)]: |f| <= 0.1716, truncation error < 4e-14
+static constexpr double c_ln[] = {1. / 15, 1. / 13, 1. / 11, 1. / 9,
+                                  1. / 7,  1. / 5,  1. / 3,  1.};
+
+// exp(r) = sum r^k/k! for k = 0...12 with |r| <= ln(2)/2, truncation error < 2e-16
+static constexpr double c_exp[] = {1. / 479001600, 1. / 39916800, 1. / 3628800,
+                                   1. / 362880,    1. / 40320,    1. / 5040,
+                                   1. / 720,       1. / 120,      1. / 24,
+                                   1. / 6,         1. / 2,        1.,
+                                   1.};
+
+// |t| limit for t = log2(10^v) to stay within normal doubles when scaling by 2^n
+static constexpr double c_exp2_max = 1020.0;
+
+////////////////////////////////////////////////////////////////////////////////
+// scalar kernels (reference and fallback for special values and tails)
+////////////////////////////////////////////////////////////////////////////////
+
+static void affine_scalar(const double* in, double* out, std::size_t n, double a,
+                          double b)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a * in[i] + b;
+    }
+}
+
+static void log10_affine_scalar(const double* in, double* out, std::size_t n, double a,
+                                double b)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a * std::log10(in[i]) + b;
+    }
+}
+
+static void affine_exp10_scalar(const double* in, double* out, std::size_t n, double a,
+                                double b)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::pow(10.0, a * in[i] + b);
+    }
+}
+
+#if defined(AXIS_KERNELS_X86)
+
+////////////////////////////////////////////////////////////////////////////////
+// sse2 kernels (2 lanes, baseline of x86-64)
+////////////////////////////////////////////////////////////////////////////////
+
+static void affine_sse2(const double* in, double* out, std::size_t n, double a,
+                        double b)
+{
+    const __m128d va = _mm_set1_pd(a);
+    const __m128d vb = _mm_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(v, va), vb));
+    }
+    affine_scalar(in + i, out + i, n - i, a, b);
+}
+
+static void log10_affine_sse2(const double* in, double* out, std::size_t n, double a,
+                              double b)
+{
+    const __m128i mant_mask = _mm_set1_epi64x(0x000fffffffffffff);
+    const __m128i one_bits = _mm_set1_epi64x(0x3ff0000000000000);
+    const __m128i magic_bits = _mm_set1_epi64x(0x4330000000000000); // 2^52
+    const __m128d magic = _mm_set1_pd(4503599627370496.0);          // 2^52
+    const __m128d bias = _mm_set1_pd(1023.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d sqrt2 = _mm_set1_pd(c_sqrt2);
+    const __m128d ln2 = _mm_set1_pd(c_ln2);
+    const __m128d dbl_min = _mm_set1_pd(DBL_MIN);
+    const __m128d dbl_max = _mm_set1_pd(DBL_MAX);
+    const __m128d va = _mm_set1_pd(a * c_log10e);
+    const __m128d vb = _mm_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(in + i);
+
+        // only normal positive values are handled here (nan compares false)
+        __m128d ok = _mm_and_pd(_mm_cmpge_pd(x, dbl_min), _mm_cmple_pd(x, dbl_max));
+        if (_mm_movemask_pd(ok) != 0x3) {
+            log10_affine_scalar(in + i, out + i, 2, a, b);
+            continue;
+        }
+
+        // x = m * 2^e with m in [1, 2)
+        __m128i bits = _mm_castpd_si128(x);
+        __m128d e = _mm_sub_pd(
+            _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), magic_bits)), magic);
+        e = _mm_sub_pd(e, bias);
+        __m128d m =
+            _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, mant_mask), one_bits));
+
+        // move m to [sqrt(0.5), sqrt(2)]
+        __m128d big = _mm_cmpgt_pd(m, sqrt2);
+        m = _mm_or_pd(_mm_and_pd(big, _mm_mul_pd(m, half)), _mm_andnot_pd(big, m));
+        e = _mm_add_pd(e, _mm_and_pd(big, one));
+
+        __m128d f = _mm_div_pd(_mm_sub_pd(m, one), _mm_add_pd(m, one));
+        __m128d f2 = _mm_mul_pd(f, f);
+        __m128d p = _mm_set1_pd(c_ln[0]);
+        for (int k = 1; k < 8; ++k) {
+            p = _mm_add_pd(_mm_mul_pd(p, f2), _mm_set1_pd(c_ln[k]));
+        }
+        __m128d ln_x = _mm_add_pd(_mm_mul_pd(e, ln2), _mm_mul_pd(_mm_add_pd(f, f), p));
+
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(ln_x, va), vb));
+    }
+    log10_affine_scalar(in + i, out + i, n - i, a, b);
+}
+
+static void affine_exp10_sse2(const double* in, double* out, std::size_t n, double a,
+                              double b)
+{
+    const __m128d magic = _mm_set1_pd(4503599627370496.0);      // 2^52
+    const __m128d round_magic = _mm_set1_pd(6755399441055744.0); // 1.5 * 2^52
+    const __m128d bias = _mm_set1_pd(1023.0);
+    const __m128d ln2 = _mm_set1_pd(c_ln2);
+    const __m128d log2_10 = _mm_set1_pd(c_log2_10);
+    const __m128d t_max = _mm_set1_pd(c_exp2_max);
+    const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffff));
+    const __m128d va = _mm_set1_pd(a);
+    const __m128d vb = _mm_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), va), vb);
+
+        // 10^v = 2^t = 2^n * e^r with n = round(t), r = (t - n) * ln(2)
+        __m128d t = _mm_mul_pd(v, log2_10);
+
+        // result must stay a normal double (nan compares false)
+        __m128d ok = _mm_cmplt_pd(_mm_and_pd(t, abs_mask), t_max);
+        if (_mm_movemask_pd(ok) != 0x3) {
+            affine_exp10_scalar(in + i, out + i, 2, a, b);
+            continue;
+        }
+
+        // round to nearest (sse2 has no round instruction)
+        __m128d nr = _mm_sub_pd(_mm_add_pd(t, round_magic), round_magic);
+        __m128d r = _mm_mul_pd(_mm_sub_pd(t, nr), ln2);
+
+        __m128d p = _mm_set1_pd(c_exp[0]);
+        for (int k = 1; k < 13; ++k) {
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(c_exp[k]));
+        }
+
+        // 2^n: biased exponent is in the low bits of (n + 1023 + 2^52)
+        __m128i nbits = _mm_castpd_si128(_mm_add_pd(_mm_add_pd(nr, bias), magic));
+        __m128d scale = _mm_castsi128_pd(_mm_slli_epi64(nbits, 52));
+
+        _mm_storeu_pd(out + i, _mm_mul_pd(p, scale));
+    }
+    affine_exp10_scalar(in + i, out + i, n - i, a, b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// avx2 kernels (4 lanes, fma)
+////////////////////////////////////////////////////////////////////////////////
+
+AXIS_TARGET_AVX2 static void affine_avx2(const double* in, double* out, std::size_t n,
+                                         double a, double b)
+{
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d vb = _mm256_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(in + i);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(v, va, vb));
+    }
+    affine_scalar(in + i, out + i, n - i, a, b);
+}
+
+AXIS_TARGET_AVX2 static void log10_affine_avx2(const double* in, double* out,
+                                               std::size_t n, double a, double b)
+{
+    const __m256i mant_mask = _mm256_set1_epi64x(0x000fffffffffffff);
+    const __m256i one_bits = _mm256_set1_epi64x(0x3ff0000000000000);
+    const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000); // 2^52
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);          // 2^52
+    const __m256d bias = _mm256_set1_pd(1023.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d sqrt2 = _mm256_set1_pd(c_sqrt2);
+    const __m256d ln2 = _mm256_set1_pd(c_ln2);
+    const __m256d dbl_min = _mm256_set1_pd(DBL_MIN);
+    const __m256d dbl_max = _mm256_set1_pd(DBL_MAX);
+    const __m256d va = _mm256_set1_pd(a * c_log10e);
+    const __m256d vb = _mm256_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(in + i);
+
+        // only normal positive values are handled here (nan compares false)
+        __m256d ok = _mm256_and_pd(_mm256_cmp_pd(x, dbl_min, _CMP_GE_OQ),
+                                   _mm256_cmp_pd(x, dbl_max, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(ok) != 0xf) {
+            log10_affine_scalar(in + i, out + i, 4, a, b);
+            continue;
+        }
+
+        // x = m * 2^e with m in [1, 2)
+        __m256i bits = _mm256_castpd_si256(x);
+        __m256d e = _mm256_sub_pd(
+            _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic_bits)),
+            magic);
+        e = _mm256_sub_pd(e, bias);
+        __m256d m = _mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_and_si256(bits, mant_mask), one_bits));
+
+        // move m to [sqrt(0.5), sqrt(2)]
+        __m256d big = _mm256_cmp_pd(m, sqrt2, _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), big);
+        e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+
+        __m256d f = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+        __m256d f2 = _mm256_mul_pd(f, f);
+        __m256d p = _mm256_set1_pd(c_ln[0]);
+        for (int k = 1; k < 8; ++k) {
+            p = _mm256_fmadd_pd(p, f2, _mm256_set1_pd(c_ln[k]));
+        }
+        __m256d ln_x = _mm256_fmadd_pd(e, ln2, _mm256_mul_pd(_mm256_add_pd(f, f), p));
+
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(ln_x, va, vb));
+    }
+    log10_affine_scalar(in + i, out + i, n - i, a, b);
+}
+
+AXIS_TARGET_AVX2 static void affine_exp10_avx2(const double* in, double* out,
+                                               std::size_t n, double a, double b)
+{
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0); // 2^52
+    const __m256d bias = _mm256_set1_pd(1023.0);
+    const __m256d ln2 = _mm256_set1_pd(c_ln2);
+    const __m256d log2_10 = _mm256_set1_pd(c_log2_10);
+    const __m256d t_max = _mm256_set1_pd(c_exp2_max);
+    const __m256d abs_mask =
+        _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffff));
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d vb = _mm256_set1_pd(b);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_fmadd_pd(_mm256_loadu_pd(in + i), va, vb);
+
+        // 10^v = 2^t = 2^n * e^r with n = round(t), r = (t - n) * ln(2)
+        __m256d t = _mm256_mul_pd(v, log2_10);
+
+        // result must stay a normal double (nan compares false)
+        __m256d ok = _mm256_cmp_pd(_mm256_and_pd(t, abs_mask), t_max, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(ok) != 0xf) {
+            affine_exp10_scalar(in + i, out + i, 4, a, b);
+            continue;
+        }
+
+        __m256d nr = _mm256_round_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_mul_pd(_mm256_sub_pd(t, nr), ln2);
+
+        __m256d p = _mm256_set1_pd(c_exp[0]);
+        for (int k = 1; k < 13; ++k) {
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(c_exp[k]));
+        }
+
+        // 2^n: biased exponent is in the low bits of (n + 1023 + 2^52)
+        __m256i nbits =
+            _mm256_castpd_si256(_mm256_add_pd(_mm256_add_pd(nr, bias), magic));
+        __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(nbits, 52));
+
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(p, scale));
+    }
+    affine_exp10_scalar(in + i, out + i, n - i, a, b);
+}
+
+static bool cpu_has_avx2_fma()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    bool fma = r[2] & (1 << 12);
+    bool osxsave = r[2] & (1 << 27);
+    bool avx = r[2] & (1 << 28);
+    // os must save the ymm registers on context switches
+    if (!fma || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(r, 7, 0);
+    return r[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // AXIS_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////////////////
+// runtime dispatch
+////////////////////////////////////////////////////////////////////////////////
+
+struct axis_kernel_set
+{
+    const char* isa;
+    void (*affine)(const double*, double*, std::size_t, double, double);
+    void (*log10_affine)(const double*, double*, std::size_t, double, double);
+    void (*affine_exp10)(const double*, double*, std::size_t, double, double);
+};
+
+static axis_kernel_set select_kernels()
+{
+#if defined(AXIS_KERNELS_X86)
+    if (cpu_has_avx2_fma()) {
+        return {"avx2", affine_avx2, log10_affine_avx2, affine_exp10_avx2};
+    }
+    return {"sse2", affine_sse2, log10_affine_sse2, affine_exp10_sse2};
+#else
+    return {"scalar", affine_scalar, log10_affine_scalar, affine_exp10_scalar};
+#endif
+}
+
+static const axis_kernel_set& kernels()
+{
+    // selected once on first use (thread safe initialization)
+    static const axis_kernel_set ks = select_kernels();
+    return ks;
+}
+
+void axis_affine(const double* in, double* out, std::size_t n, double a, double b)
+{
+    kernels().affine(in, out, n, a, b);
+}
+
+void axis_log10_affine(const double* in, double* out, std::size_t n, double a,
+                       double b)
+{
+    kernels().log10_affine(in, out, n, a, b);
+}
+
+void axis_affine_exp10(const double* in, double* out, std::size_t n, double a,
+                       double b)
+{
+    kernels().affine_exp10(in, out, n, a, b);
+}
+
+const char* axis_kernels_isa() { return kernels().isa; }
@@ -5,16 +5,26 @@
 #include <QString>
 #include <QWidget>
 
-#include <algorithm> // std::reverse
+#include <algorithm> // std::max
+#include <atomic>
+#include <cstdlib> // std::abs
 #include <cmath> // for mathematical functions used for axis scaling (e.g. log10, pow, ceil)
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "axis_kernels.hpp"
+
 #include "fmt/format.h"
 #include "fmt/ranges.h"
 
+std::uint64_t new_version_stamp()
+{
+    static std::atomic<std::uint64_t> stamp{0};
+    return ++stamp;
+}
+
 Axis::Axis(widget_axis_data wd_in, axis_data ad_in) : wd{wd_in}, ad{ad_in}
 {
 
@@ -111,15 +121,54 @@ double Axis::w_to_au(int npos) const
     }
 }
 
-void Axis::draw(QPainter* qp, int offset)
+// bulk unscaled axis to widget transformation
+void Axis::au_to_w(std::span<const double> unscaled_values, std::span<double> npos) const
+{
+    if (npos.size() < unscaled_values.size())
+        throw std::runtime_error("Output span too small for bulk transformation.");
+
+    // sf * (value - min) + mo  ==  sf * value + (mo - sf * min)
+    switch (ad.scal) {
+        case axis_scal::linear:
+            axis_affine(unscaled_values.data(), npos.data(), unscaled_values.size(), sf,
+                        mo - sf * ad.rng.min);
+            break;
+
+        case axis_scal::logarithmic:
+            axis_log10_affine(unscaled_values.data(), npos.data(),
+                              unscaled_values.size(), sf, mo - sf * ad.rng.min);
+            break;
+    }
+}
+
+// bulk widget to unscaled axis transformation
+void Axis::w_to_au(std::span<const double> npos, std::span<double> unscaled_values) const
+{
+    if (unscaled_values.size() < npos.size())
+        throw std::runtime_error("Output span too small for bulk transformation.");
+
+    // (npos - mo) / sf + min  ==  npos / sf + (min - mo / sf)
+    switch (ad.scal) {
+        case axis_scal::linear:
+            axis_affine(npos.data(), unscaled_values.data(), npos.size(), 1.0 / sf,
+                        ad.rng.min - mo / sf);
+            break;
+
+        case axis_scal::logarithmic:
+            axis_affine_exp10(npos.data(), unscaled_values.data(), npos.size(),
+                              1.0 / sf, ad.rng.min - mo / sf);
+            break;
+    }
+}
+
+void Axis::draw(QPainter* qp, int offset, const cs_style& st, Label_cache& labels,
+                int label_advance)
 {
 
-    // Create font
-    qp->setFont(QFont("Helvetica", 12, QFont::Normal));
-    // Set font color
-    // qp->setPen(Qt::white);
-    // Get QFontMetrics reference
-    QFontMetrics fm = qp->fontMetrics();
+    // fonts and metrics are resolved by the style
+    qp->setFont(st.notch_font);
+    qp->setPen(st.theme.axis_pen);
+    const QFontMetrics& fm = st.notch_fm;
 
     switch (ad.dir) {
         case axis_dir::x: {
@@ -127,19 +176,19 @@ void Axis::draw(QPainter* qp, int offset)
             qp->drawLine(nmin(), offset, nmax(), offset);
 
             // major notches
-            std::vector<double> major_val = get_major_pos();
+            const std::vector<double>& major_val = get_major_pos();
             for (int i = 0; i < major_val.size(); ++i) {
                 int npos = a_to_w(major_val[i]);
                 if (npos >= nmin() && npos <= nmax()) { // just draw within cs area
                     qp->drawLine(npos, offset, npos, offset + 8);
-                    // notch labels
-                    QString s = QString::number(major_val[i]);
-                    qp->drawText(npos - fm.horizontalAdvance(s) / 2,
-                                 offset + fm.height() + 6, s);
+                    // notch labels (prepared once, placed at the baseline)
+                    label_text l = labels.number(major_val[i], st.notch_font);
+                    qp->drawStaticText(npos - l.advance / 2,
+                                       offset + fm.height() + 6 - l.ascent, l.text);
                 }
             }
             // minor notches (w/o notch labels)
-            std::vector<double> minor_val = get_minor_pos(major_val);
+            const std::vector<double>& minor_val = get_minor_pos();
             for (int i = 0; i < minor_val.size(); ++i) {
                 int npos = a_to_w(minor_val[i]);
                 if (npos >= nmin() && npos <= nmax()) { // just draw within cs area
@@ -149,21 +198,17 @@ void Axis::draw(QPainter* qp, int offset)
 
             // x axis label
             qp->save();
-            qp->setFont(QFont("Helvetica", 14, QFont::Bold));
-            QFontMetrics fmbx = qp->fontMetrics();
-            qp->drawText((ad.rng.max - ad.rng.min) / 2 * sf + mo -
-                             fmbx.horizontalAdvance(label) / 2,
-                         offset + fmbx.height() + 25, label);
+            qp->setFont(st.label_font);
+            qp->drawText((ad.rng.max - ad.rng.min) / 2 * sf + mo - label_advance / 2,
+                         offset + st.label_fm.height() + 25, label);
             qp->restore();
 
             // notify user on log10 scaling of axis
             if (ad.scal == axis_scal::logarithmic) {
                 qp->save();
-                qp->setFont(QFont("Helvetica", 14, QFont::Normal));
-                QFontMetrics fmbx = qp->fontMetrics();
-                qp->drawText((ad.rng.max - ad.rng.min) * sf + mo -
-                                 fmbx.horizontalAdvance(QString("log10(x)")),
-                             offset + fmbx.height() + 25, QString("log10(x)"));
+                qp->setFont(st.log_font);
+                qp->drawText((ad.rng.max - ad.rng.min) * sf + mo - st.log_x_advance,
+                             offset + st.log_fm.height() + 25, QString("log10(x)"));
                 qp->restore();
             }
 
@@ -175,19 +220,19 @@ void Axis::draw(QPainter* qp, int offset)
             qp->drawLine(offset, nmin(), offset, nmax());
 
             // major notches
-            std::vector<double> major_val = get_major_pos();
+            const std::vector<double>& major_val = get_major_pos();
             for (int i = 0; i < major_val.size(); ++i) {
                 int npos = a_to_w(major_val[i]);
                 if (npos <= nmin() && npos >= nmax()) { // just draw within cs area (y!)
                     qp->drawLine(offset - 8, npos, offset, npos);
-                    // notch labels
-                    QString s = QString::number(major_val[i]);
-                    qp->drawText(offset - fm.horizontalAdvance(s) - 11,
-                                 npos + fm.height() / 3, s);
+                    // notch labels (prepared once, placed at the baseline)
+                    label_text l = labels.number(major_val[i], st.notch_font);
+                    qp->drawStaticText(offset - l.advance - 11,
+                                       npos + fm.height() / 3 - l.ascent, l.text);
                 }
             }
             // minor notches (w/o notch labels)
-            std::vector<double> minor_val = get_minor_pos(major_val);
+            const std::vector<double>& minor_val = get_minor_pos();
             for (int i = 0; i < minor_val.size(); ++i) {
                 int npos = a_to_w(minor_val[i]);
                 if (npos <= nmin() && npos >= nmax()) { // just draw within cs area (y!)
@@ -197,11 +242,9 @@ void Axis::draw(QPainter* qp, int offset)
 
             // y axis label
             qp->save();
-            qp->setFont(QFont("Helvetica", 14, QFont::Bold));
-            QFontMetrics fmby = qp->fontMetrics();
-            qp->translate(offset - fmby.height() - 30,
-                          (ad.rng.max - ad.rng.min) * sf / 2 + mo +
-                              fmby.horizontalAdvance(label) / 2);
+            qp->setFont(st.label_font);
+            qp->translate(offset - st.label_fm.height() - 30,
+                          (ad.rng.max - ad.rng.min) * sf / 2 + mo + label_advance / 2);
             qp->rotate(-90);
             qp->drawText(0, 0, label);
             qp->restore();
@@ -209,9 +252,8 @@ void Axis::draw(QPainter* qp, int offset)
             // notify user on log10 scaling of axis
             if (ad.scal == axis_scal::logarithmic) {
                 qp->save();
-                qp->setFont(QFont("Helvetica", 14, QFont::Normal));
-                QFontMetrics fmby = qp->fontMetrics();
-                qp->translate(offset - fmby.height() - 30,
+                qp->setFont(st.log_font);
+                qp->translate(offset - st.log_fm.height() - 30,
                               (ad.rng.max - ad.rng.min) * sf + mo);
                 qp->rotate(90);
                 qp->drawText(0, 0, QString("log10(y)"));
@@ -223,133 +265,118 @@ void Axis::draw(QPainter* qp, int offset)
     }
 }
 
-std::vector<double> Axis::get_major_pos() const
+Axis Axis::part(int n1, int n2) const
 {
-    // return coodinates of major axis notches
-    std::vector<double> notches;
-
-    // combine sweep left and sweep right starting from anchor point
-    // sweep range is between ad.rng.min - ad.ticks.major_delta and ad.rng.max +
-    // ad.ticks.major_delta to have at least the two major notches needed to draw the
-    // minor notches
-
-    switch (ad.scal) {
-
-        case axis_scal::linear: {
-            double value = ad.ticks.major_anchor;
-            while (value >= ad.rng.min - ad.ticks.major_delta) { // sweep left
-                if (value >= ad.rng.min - ad.ticks.major_delta &&
-                    value <= ad.rng.max + ad.ticks.major_delta) { // in interval now
-                    notches.push_back(value);
-                }
-                value -= ad.ticks.major_delta;
-            }
-            // reverse vector
-            std::reverse(notches.begin(), notches.end());
-
-            value = ad.ticks.major_anchor;
-            while (value <= ad.rng.max + ad.ticks.major_delta) { // sweep right
-                if (value >= ad.rng.min - ad.ticks.major_delta &&
-                    value <= ad.rng.max + ad.ticks.major_delta &&
-                    value !=
-                        ad.ticks.major_anchor) { // in interval now (w/o anchor point)
-                    notches.push_back(value);
-                }
-                value += ad.ticks.major_delta;
-            }
+    widget_axis_data wd_p = wd;
+    axis_data ad_p = ad;
+    ad_p.rng = axis_rng(std::min(w_to_a(n1), w_to_a(n2)), std::max(w_to_a(n1), w_to_a(n2)));
+    wd_p.a_length = std::abs(n2 - n1);
+    switch (ad.dir) {
+        case axis_dir::x:
+            wd_p.a_offset = std::min(n1, n2);
             break;
-        }
-        case axis_scal::logarithmic: // ignore user settings of anchor, major_delta
-                                     // and minor_intervals and create standardized
-                                     // log10 axis
-        {
-            double value = 1.0;                 // standard anchor value
-            while (value >= ad.rng.min - 1.0) { // sweep left
-                if (value >= ad.rng.min - 1.0 &&
-                    value <= ad.rng.max + 1.0) { // in interval now
-                    notches.push_back(value);
-                }
-                value -= 1.0;
-            }
-            // reverse vector
-            std::reverse(notches.begin(), notches.end());
-
-            value = 1.0;                        // standard anchor value
-            while (value <= ad.rng.max + 1.0) { // sweep right
-                if (value >= ad.rng.min - 1.0 && value <= ad.rng.max + 1.0 &&
-                    value != 1.0) { // in interval now (w/o anchor point)
-                    notches.push_back(value);
-                }
-                value += 1.0;
-            }
+        case axis_dir::y:
+            // offset is measured from the bottom of the paint device
+            wd_p.a_offset = wd.w_size - std::max(n1, n2);
             break;
-        }
     }
+    return Axis(wd_p, ad_p);
+}
+
+const std::vector<double>& Axis::get_major_pos() const
+{
+    update_ticks();
 
     // if (ad.dir == axis_dir::x) {
-    //   fmt::print("x major notches = {}\n", notches);
+    //   fmt::print("x major notches = {}\n", tc.major);
     // }
     // if (ad.dir == axis_dir::y) {
-    //   fmt::print("y major notches = {}\n", notches);
+    //   fmt::print("y major notches = {}\n", tc.major);
     // }
-    return notches;
+    return tc.major;
 } // get_major_pos()
 
-std::vector<double> Axis::get_minor_pos(const std::vector<double>& major_pos) const
+const std::vector<double>& Axis::get_minor_pos() const
 {
-    // return coodinates of minor axis notches
-    // (excluding the position of the major notches)
-
-    std::vector<double> notches;
-
-    // the major_pos vector must at least contain two major notches so that we can
-    // return something meaningful (otherwise the notches vector remains empty)
-    if (major_pos.size() >= 2) {
-
-        switch (ad.scal) {
-
-            case axis_scal::linear: {
-                // go through all major notches (there are at least two)
-                int last = major_pos.size() - 1;
-                for (int i = 0; i < last; ++i) {
-                    double delta =
-                        (major_pos[i + 1] - major_pos[i]) / ad.ticks.minor_intervals;
-                    for (int j = 1; j < ad.ticks.minor_intervals;
-                         ++j) { // skip the major notches
-                        notches.push_back(j * delta + major_pos[i]);
-                    }
-                }
-                break;
-            }
-            case axis_scal::logarithmic: {
-                // go through all major notches (there are at least two)
-                int last = major_pos.size() - 1;
-                for (int i = 0; i < last; ++i) {
-                    double value = major_pos[i];
-                    double delta = std::pow(10, std::floor(value));
-                    for (int j = 0; j < 8; ++j) {
-                        value = std::log10(std::pow(10, value) + delta);
-                        notches.push_back(value);
-                    }
-                }
-                break;
-            }
-        }
-    }
+    update_ticks();
 
     // if (ad.dir == axis_dir::x) {
-    //   fmt::print("x minor notches = {}\n", notches);
-    //   fmt::print("x minor notches = {:.3f}\n", fmt::join(notches, ", "));
+    //   fmt::print("x minor notches = {:.3f}\n", fmt::join(tc.minor, ", "));
     // }
     // if (ad.dir == axis_dir::y) {
-    //   fmt::print("y minor notches = {}\n", notches);
-    //   // fmt::print("y minor notches = {:.3f}\n", fmt::join(notches, ", "));
+    //   fmt::print("y minor notches = {:.3f}\n", fmt::join(tc.minor, ", "));
     // }
-    return notches;
+    return tc.minor;
 } // get_minor_pos()
 
+void Axis::update_ticks() const
+{
+    if (tc.rng.min == ad.rng.min && tc.rng.max == ad.rng.max && tc.scal == ad.scal &&
+        tc.ticks.major_anchor == ad.ticks.major_anchor &&
+        tc.ticks.major_delta == ad.ticks.major_delta &&
+        tc.ticks.minor_intervals == ad.ticks.minor_intervals) {
+        return; // still valid
+    }
+    tc.rng = ad.rng;
+    tc.scal = ad.scal;
+    tc.ticks = ad.ticks;
+    tc.major.clear();
+    tc.minor.clear();
+
+    // major notches are anchor + k*delta within ad.rng.min - delta and ad.rng.max +
+    // delta to have at least the two major notches needed to draw the minor
+    // notches; log10 axis ignore user settings of anchor, major_delta and
+    // minor_intervals and create standardized log10 axis
+    bool log = ad.scal == axis_scal::logarithmic;
+    double anchor = log ? 1.0 : ad.ticks.major_anchor;
+    double delta = log ? 1.0 : ad.ticks.major_delta;
+    if (!(delta > 0.0) || !std::isfinite(anchor) || !std::isfinite(ad.rng.min) ||
+        !std::isfinite(ad.rng.max)) {
+        return;
+    }
+
+    double k_first = std::ceil((ad.rng.min - delta - anchor) / delta);
+    double k_last = std::floor((ad.rng.max + delta - anchor) / delta);
+    if (!(k_last >= k_first)) return;
+
+    // too many notches (e.g. zoomed out far): keep every stride-th one only
+    double stride = std::ceil((k_last - k_first + 1) / max_major_ticks);
+    stride = std::max(stride, 1.0);
+    k_first = std::ceil(k_first / stride) * stride;
+    for (double k = k_first; k <= k_last; k += stride) {
+        tc.major.push_back(anchor + k * delta);
+    }
+
+    // minor notches between each pair of major notches (w/o the major notches)
+    if (tc.major.size() < 2 || stride > 1.0) return;
+    std::size_t n_intervals = tc.major.size() - 1;
+
+    if (log) {
+        // decades: log10(j * 10^k) = k + log10(j) for j = 2 .. 9
+        static const double log_j[8] = {std::log10(2.0), std::log10(3.0), std::log10(4.0),
+                                        std::log10(5.0), std::log10(6.0), std::log10(7.0),
+                                        std::log10(8.0), std::log10(9.0)};
+        if (n_intervals * 8 > max_minor_ticks) return;
+        for (std::size_t i = 0; i < n_intervals; ++i) {
+            for (double l : log_j) {
+                tc.minor.push_back(tc.major[i] + l);
+            }
+        }
+    }
+    else {
+        int n = ad.ticks.minor_intervals;
+        if (n < 2 || n_intervals * (n - 1) > max_minor_ticks) return;
+        double minor_delta = delta / n;
+        for (std::size_t i = 0; i < n_intervals; ++i) {
+            for (int j = 1; j < n; ++j) { // skip the major notches
+                tc.minor.push_back(tc.major[i] + j * minor_delta);
+            }
+        }
+    }
+} // update_ticks()
+
 Coordsys::Coordsys(Axis x_in, Axis y_in, coordsys_data cd_in) :
-    x{x_in}, y{y_in}, cd{cd_in}, title{cd.title.c_str()}
+    x{x_in}, y{y_in}, cd{cd_in}, title{cd.title.c_str()}, m_version{new_version_stamp()}
 {
     // store target ratios once per Coordsys in order to allow for
     // scrollwheel scaling based on inital ratios set by user as target values
@@ -364,15 +391,27 @@ Coordsys::Coordsys(Axis x_in, Axis y_in, coordsys_data cd_in) :
 }
 
 void Coordsys::draw(QPainter* qp)
+{
+
+    draw_grid(qp);
+    draw_axes(qp);
+
+    // clipping area is active area of coordsys
+    QRegion clip_area(
+        QRect(x.nmin(), y.nmax(), x.nmax() - x.nmin(), y.nmin() - y.nmax()));
+    qp->setClipRegion(clip_area);
+}
+
+void Coordsys::draw_grid(QPainter* qp)
 {
 
     qp->save();
 
     // draw helper lines
-    qp->setPen(QPen(Qt::gray, 1, Qt::DotLine));
+    qp->setPen(st->theme.grid_pen);
 
     { // draw helper lines through major notches
-        std::vector<double> major_val = x.get_major_pos();
+        const std::vector<double>& major_val = x.get_major_pos();
         for (int i = 0; i < major_val.size(); ++i) {
             int npos = x.a_to_w(major_val[i]);
             if (npos >= x.nmin() && npos <= x.nmax()) { // just draw within cs area
@@ -382,7 +421,7 @@ void Coordsys::draw(QPainter* qp)
     }
 
     { // draw helper lines through major notches
-        std::vector<double> major_val = y.get_major_pos();
+        const std::vector<double>& major_val = y.get_major_pos();
         for (int i = 0; i < major_val.size(); ++i) {
             int npos = y.a_to_w(major_val[i]);
             if (npos <= y.nmin() && npos >= y.nmax()) { // just draw within cs area (y!)
@@ -392,10 +431,23 @@ void Coordsys::draw(QPainter* qp)
     }
 
     qp->restore();
+}
+
+void Coordsys::draw_axes(QPainter* qp)
+{
+
+    // labels and title are measured once per style (not per view: the axes are
+    // rebuilt on each pan and zoom)
+    if (measured_style != st->id) {
+        x_label_advance = st->label_fm.horizontalAdvance(x.get_label());
+        y_label_advance = st->label_fm.horizontalAdvance(y.get_label());
+        title_advance = st->title_fm.horizontalAdvance(title);
+        measured_style = st->id;
+    }
 
     // draw the axis, using the corresponding min values
-    x.draw(qp, y.nmin());
-    y.draw(qp, x.nmin());
+    x.draw(qp, y.nmin(), *st, *tick_labels, x_label_advance);
+    y.draw(qp, x.nmin(), *st, *tick_labels, y_label_advance);
 
     // make sure the outer frame is always drawn
     // regardless of the helper lines through the major notches
@@ -404,21 +456,63 @@ void Coordsys::draw(QPainter* qp)
 
     // draw title
     qp->save();
-    qp->setFont(QFont("Helvetica", 16, QFont::Bold));
-    QFontMetrics fmbx = qp->fontMetrics();
-    qp->drawText((x.nmax() + x.nmin()) / 2 - fmbx.horizontalAdvance(title) / 2,
-                 y.nmax() - fmbx.height() / 2, title);
+    qp->setFont(st->title_font);
+    qp->drawText((x.nmax() + x.nmin()) / 2 - title_advance / 2,
+                 y.nmax() - st->title_fm.height() / 2, title);
     qp->restore();
+}
 
-    // clipping area is active area of coordsys
-    QRegion clip_area(
-        QRect(x.nmin(), y.nmax(), x.nmax() - x.nmin(), y.nmin() - y.nmax()));
-    qp->setClipRegion(clip_area);
+Coordsys Coordsys::part(const QRect& r) const
+{
+    // a copy shares the style and keeps the version (the view is the same)
+    Coordsys p = *this;
+    p.x = x.part(r.left(), r.left() + r.width());
+    p.y = y.part(r.top() + r.height(), r.top()); // y grows downwards
+    return p;
+}
+
+void Coordsys::set_theme(const cs_theme& t)
+{
+    m_version = new_version_stamp();
+    st = std::make_shared<const cs_style>(t);
+}
+
+view_state Coordsys::get_view_state() const
+{
+    view_state vs;
+    vs.x_rng = axis_rng(x.min(), x.max());
+    vs.y_rng = axis_rng(y.min(), y.max());
+    vs.x_major_delta = x.major_delta();
+    vs.y_major_delta = y.major_delta();
+    vs.x_scal = x.scaling();
+    vs.y_scal = y.scaling();
+    return vs;
+}
+
+void Coordsys::set_view_state(const view_state& vs)
+{
+
+    m_version = new_version_stamp();
+
+    // keep widget data and labels of the current axes
+    axis_data adx = x.get_axis_data();
+    adx.rng = vs.x_rng;
+    adx.ticks.major_delta = vs.x_major_delta;
+    adx.scal = vs.x_scal;
+    x = Axis(x.get_widget_axis_data(), adx);
+
+    axis_data ady = y.get_axis_data();
+    ady.rng = vs.y_rng;
+    ady.ticks.major_delta = vs.y_major_delta;
+    ady.scal = vs.y_scal;
+    y = Axis(y.get_widget_axis_data(), ady);
 }
 
 void Coordsys::adjust_to_resized_widget(int new_w_width, int new_w_height)
 {
 
+    m_version = new_version_stamp();
+
     // needs adjustment of axis if corresponding widget size has changed
     if (new_w_width != x.widget_size()) {
 
@@ -448,6 +542,8 @@ void Coordsys::adjust_to_resized_widget(int new_w_width, int new_w_height)
 void Coordsys::adjust_to_pan(double dx, double dy)
 {
 
+    m_version = new_version_stamp();
+
     if (dx != 0.0) {
 
         widget_axis_data wdx = x.get_widget_axis_data();
@@ -475,6 +571,8 @@ void Coordsys::adjust_to_zoom(double new_xmin, double new_xmax, double new_ymin,
                               double new_ymax)
 {
 
+    m_version = new_version_stamp();
+
     // get data of existing axis
     widget_axis_data wdx = x.get_widget_axis_data();
     axis_data adx = x.get_axis_data();
@@ -585,6 +683,8 @@ void Coordsys::adjust_to_wheel_zoom(double new_xmin, double new_xmax, double new
                                     double ytarget_ratio)
 {
 
+    m_version = new_version_stamp();
+
     // get data of existing axis
     widget_axis_data wdx = x.get_widget_axis_data();
     axis_data adx = x.get_axis_data();
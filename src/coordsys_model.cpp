@@ -1,186 +1,771 @@
 #include "coordsys_model.hpp"
+#include "thread_pool.hpp"
 
-void Coordsys_model::draw(QPainter* qp, Coordsys* cs)
+#include <algorithm> // std::min, std::lower_bound, std::is_sorted
+#include <chrono>
+#include <cmath> // std::floor, std::pow, std::ceil, std::isfinite, std::log10
+#include <stdexcept>
+#include <string> // std::to_string
+#include <utility> // std::move
+
+static bbox2d ln_box(const ln_view& v)
+{
+    // bounding box of the finite vertices of a line
+    // (lines w/o finite vertices get a non-finite box and are never drawn)
+    bbox2d b{INFINITY, -INFINITY, INFINITY, -INFINITY};
+    for (std::size_t j = 0; j < v.n; ++j)
+    {
+        double x = v.xv(j);
+        double y = v.yv(j);
+        if (std::isfinite(x) && std::isfinite(y))
+        {
+            b.xmin = std::min(b.xmin, x);
+            b.xmax = std::max(b.xmax, x);
+            b.ymin = std::min(b.ymin, y);
+            b.ymax = std::max(b.ymax, y);
+        }
+    }
+    return b;
+}
+
+static bool ln_x_sorted(const ln_view& v)
 {
+    // non-finite x values do not allow binary searches on x
+    // (non-finite y values are fine, they are gaps in the line)
+    for (std::size_t j = 0; j < v.n; ++j)
+    {
+        if (!std::isfinite(v.xv(j))) return false;
+        if (j > 0 && v.xv(j) < v.xv(j - 1)) return false;
+    }
+    return true;
+}
 
+template <typename Pred>
+static std::size_t ln_partition_point(const ln_view& v, std::size_t lo, Pred pred)
+{
+    // first vertex in [lo, n) with !pred(x) (requires x values in ascending order)
+    std::size_t hi = v.n;
+    while (lo < hi)
+    {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (pred(v.xv(mid))) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void Coordsys_model::draw(QPainter* qp, Coordsys* cs, std::stop_token stop,
+                          stream_state* drawn)
+{
+
+    // a requested stop ends drawing early at the next check (the result is
+    // incomplete then and should be discarded by the caller)
     qp->save();
 
+    // visible range (plus marker sizes and pen widths) in model coordinates
+    // only items intersecting it are drawn
+    bbox2d view = view_box(cs);
+
     { // draw vectors:
 
-        // draw each poly line
-        for (int i = 0; i < vec.size(); ++i)
+        // one drawLines call per run of vectors with the same style
+        vec_grid.query(view, vis);
+        style_runs(vis, [this](std::size_t i) { return vec_style[i]; });
+        for (std::size_t b = 0; b + 1 < bucket.size(); ++b)
         {
-            if (vec_id[i].active)
-            { // only draw active vectors into cs
-
-                qp->setPen(vec_mark[i].pen);
+            // hidden groups are skipped as a whole
+            if (bucket[b] == bucket[b + 1] ||
+                grps[vec_style_grp[vec_style[vis[bucket[b]]]]].hidden)
+                continue;
 
-                int nx1 = cs->x.au_to_w(vec[i].from.x);
-                int ny1 = cs->y.au_to_w(vec[i].from.y);
-                int nx2 = cs->x.au_to_w(vec[i].to.x);
-                int ny2 = cs->y.au_to_w(vec[i].to.y);
-                qp->drawLine(nx1, ny1, nx2, ny2);
+            vec_buf.clear();
+            for (std::size_t k = bucket[b]; k < bucket[b + 1]; ++k)
+            {
+                std::size_t i = vis[k];
+                if (vec_id[i].active)
+                { // only draw active vectors into cs
+                    int nx1 = cs->x.au_to_w(vec[i].from.x);
+                    int ny1 = cs->y.au_to_w(vec[i].from.y);
+                    int nx2 = cs->x.au_to_w(vec[i].to.x);
+                    int ny2 = cs->y.au_to_w(vec[i].to.y);
+                    vec_buf.emplace_back(nx1, ny1, nx2, ny2);
+                }
             }
+            if (vec_buf.empty()) continue;
+
+            qp->setPen(vec_styles[vec_style[vis[bucket[b]]]].pen);
+            qp->drawLines(vec_buf.data(), vec_buf.size());
         }
     }
 
+    if (stop.stop_requested())
+    {
+        qp->restore();
+        return;
+    }
+
     { // draw lines:
 
-        // draw each poly line
-        for (int i = 0; i < line.size(); ++i)
+        auto t_start = std::chrono::steady_clock::now();
+        std::size_t n_vertices{0};
+
+        // visible active lines of shown groups in the order of the model, pen
+        // and brush are set once per run of lines with the same style (the brush
+        // is only used for the areas of lines with mark_area)
+        line_grid.query(view, vis);
+        style_runs(vis, [this](std::size_t i) { return line_style[i]; });
+
+        // runs of hidden groups are dropped as a whole, of the other runs only
+        // the inactive lines (vis and bucket are compacted in place)
+        std::size_t n_vis = 0;
+        for (std::size_t b = 0; b + 1 < bucket.size(); ++b)
         {
-            if (line_id[i].active)
-            { // only draw active lines into cs
+            std::size_t begin = bucket[b];
+            std::size_t end = bucket[b + 1];
+            bucket[b] = n_vis;
+            if (grps[line_style_grp[line_style[vis[begin]]]].hidden) continue;
 
-                qp->setPen(line_mark[i].pen);
+            for (std::size_t k = begin; k < end; ++k)
+            {
+                if (line_id[vis[k]].active) vis[n_vis++] = vis[k];
+            }
+        }
+        bucket.back() = n_vis;
+        vis.resize(n_vis);
 
-                // connect all points on each line
-                for (int j = 0; j < line[i].size() - 1; ++j)
-                {
-                    int nx1 = cs->x.au_to_w(line[i][j].x);
-                    int ny1 = cs->y.au_to_w(line[i][j].y);
-                    int nx2 = cs->x.au_to_w(line[i][j + 1].x);
-                    int ny2 = cs->y.au_to_w(line[i][j + 1].y);
-                    qp->drawLine(nx1, ny1, nx2, ny2);
-                }
+        // prepare the geometry of all lines in parallel ...
+        prepare_lns(cs, stop);
 
-                if (line_mark[i].mark_area)
-                {
-                    qp->setPen(line_mark[i].pen);
-                    qp->setBrush(line_mark[i].area_col);
+        // ... and hand it over to the painter in order
+        for (std::size_t b = 0; b + 1 < bucket.size() && !stop.stop_requested(); ++b)
+        {
+            if (bucket[b] == bucket[b + 1]) continue;
 
-                    QPainterPath polyPath;
-                    polyPath.moveTo(cs->x.au_to_w(line[i][0].x), cs->y.au_to_w(0.0));
+            const ln2d_mark& m = line_styles[line_style[vis[bucket[b]]]];
+            qp->setPen(m.pen);
+            if (m.mark_area) qp->setBrush(m.area_col);
 
-                    // connect all points on each line
-                    for (int j = 0; j < line[i].size(); ++j)
-                    {
-                        polyPath.lineTo(cs->x.au_to_w(line[i][j].x),
-                                        cs->y.au_to_w(line[i][j].y));
-                    }
+            for (std::size_t k = bucket[b]; k < bucket[b + 1]; ++k)
+            {
+                const ln_prep& lp = ln_preps[k];
+                n_vertices += lp.n_vertices;
 
-                    polyPath.lineTo(cs->x.au_to_w(line[i][line[i].size() - 1].x),
-                                    cs->y.au_to_w(0.0));
-                    polyPath.closeSubpath();
-                    qp->drawPath(polyPath);
+                switch (ln_mode)
+                {
+                case ln_draw::segments:
+                    draw_ln_segments(qp, cs, vis[k]);
+                    break;
+                case ln_draw::polyline:
+                    draw_ln_polyline(qp, lp);
+                    break;
                 }
+
+                if (m.mark_area) qp->drawPath(lp.area);
             }
         }
+        qp->setBrush(Qt::NoBrush);
+
+        std::chrono::duration<double> t_draw =
+            std::chrono::steady_clock::now() - t_start;
+        ln_stats.n_vertices = n_vertices;
+        ln_stats.t_draw = t_draw.count();
     }
 
-    { // draw pts (add other stuff above to make pt_mark in pts appear on top):
+    if (stop.stop_requested())
+    {
+        qp->restore();
+        return;
+    }
 
-        for (int i = 0; i < pt.size(); ++i)
-        {
-            if (pt_id[i].active)
-            { // only draw active pts into cs
-                int nx = cs->x.au_to_w(pt[i].x);
-                int ny = cs->y.au_to_w(pt[i].y);
-                qp->setPen(pt_mark[i].pen);
+    draw_streams(qp, cs, drawn);
+
+    { // draw pts (add other stuff above to make pt_mark in pts appear on top):
 
-                switch (pt_mark[i].symbol)
+        // transform the coordinates of the visible points as whole columns
+        // (in chunks on all threads of the pool)
+        pt_grid.query(view, pt_x, pt_y, vis);
+        pt_nx.resize(vis.size());
+        pt_ny.resize(vis.size());
+        pt_vis_style.resize(vis.size());
+        bool all_vis = vis.size() == pt_x.size();
+        Thread_pool::global().parallel_for(
+            vis.size(), pt_grain, [&](std::size_t begin, std::size_t end, unsigned) {
+                std::size_t n = end - begin;
+                std::span<double> nx = std::span(pt_nx).subspan(begin, n);
+                std::span<double> ny = std::span(pt_ny).subspan(begin, n);
+                if (all_vis)
                 {
-                case Symbol::plus:
+                    cs->x.au_to_w(std::span(pt_x).subspan(begin, n), nx);
+                    cs->y.au_to_w(std::span(pt_y).subspan(begin, n), ny);
+                }
+                else
                 {
-                    qp->drawLine(nx - pt_mark[i].nsize, ny, nx + pt_mark[i].nsize,
-                                 ny);
-                    qp->drawLine(nx, ny - pt_mark[i].nsize, nx,
-                                 ny + pt_mark[i].nsize);
-                    break;
+                    for (std::size_t k = begin; k < end; ++k)
+                    {
+                        pt_nx[k] = pt_x[vis[k]];
+                        pt_ny[k] = pt_y[vis[k]];
+                    }
+                    cs->x.au_to_w(nx, nx);
+                    cs->y.au_to_w(ny, ny);
                 }
-                case Symbol::cross:
+                for (std::size_t k = begin; k < end; ++k)
                 {
-                    qp->drawLine(nx - pt_mark[i].nsize, ny - pt_mark[i].nsize,
-                                 nx + pt_mark[i].nsize, ny + pt_mark[i].nsize);
-                    qp->drawLine(nx - pt_mark[i].nsize, ny + pt_mark[i].nsize,
-                                 nx + pt_mark[i].nsize, ny - pt_mark[i].nsize);
-                    break;
+                    std::size_t i = vis[k];
+                    // only draw active pts of shown groups into cs
+                    pt_vis_style[k] = pt_hidden(i) ? no_style : pt_style[i];
                 }
-                case Symbol::circle:
+            });
+
+        // marked vertices of visible lines are taken directly from the lines,
+        // culled with view like the points before they are transformed
+        // (x-sorted lines: only the vertices within the x range of view)
+        for (const ln_pt_marks& r : line_pt_marks)
+        {
+            if (line_hidden(r.line) || grps[pt_style_grp[r.style]].hidden ||
+                !view.intersects(line_grid.item_box(r.line)))
+                continue;
+
+            ln_view v = ln_vertices(r.line);
+            std::size_t first = 0;
+            std::size_t last = v.n;
+            if (line_sorted[r.line])
+            {
+                first = ln_partition_point(v, 0, [&](double x) { return x < view.xmin; });
+                last = ln_partition_point(v, first,
+                                          [&](double x) { return x <= view.xmax; });
+                first = (first + r.delta - 1) / r.delta * r.delta; // marked vertex
+            }
+
+            std::size_t k0 = pt_nx.size();
+            for (std::size_t j = first; j < last; j += r.delta)
+            {
+                // (comparisons are false for non-finite vertices)
+                double x = v.xv(j);
+                double y = v.yv(j);
+                if (x >= view.xmin && x <= view.xmax && y >= view.ymin && y <= view.ymax)
                 {
-                    qp->drawEllipse(QPoint(nx, ny), pt_mark[i].nsize,
-                                    pt_mark[i].nsize);
-                    break;
+                    pt_nx.push_back(x);
+                    pt_ny.push_back(y);
                 }
-                case Symbol::square:
+            }
+            std::span<double> nx = std::span(pt_nx).subspan(k0);
+            std::span<double> ny = std::span(pt_ny).subspan(k0);
+            cs->x.au_to_w(nx, nx);
+            cs->y.au_to_w(ny, ny);
+            pt_vis_style.resize(pt_nx.size(), r.style);
+        }
+
+        // marks are drawn in the order of the points: consecutive marks with
+        // sprites are copied in one pass, consecutive marks w/o sprite are drawn
+        // directly with one pen per run of the same style
+        auto draw_direct = [&] {
+            // pt_direct contains positions in pt_nx, pt_ny
+            style_runs(pt_direct, [this](std::size_t k) { return pt_vis_style[k]; });
+            for (std::size_t b = 0; b + 1 < bucket.size(); ++b)
+            {
+                const pt2d_mark& pm = pt_styles[pt_vis_style[pt_direct[bucket[b]]]];
+                qp->setPen(pm.pen);
+                for (std::size_t j = bucket[b]; j < bucket[b + 1]; ++j)
                 {
-                    qp->drawLine(nx - pt_mark[i].nsize, ny - pt_mark[i].nsize,
-                                 nx + pt_mark[i].nsize, ny - pt_mark[i].nsize);
-                    qp->drawLine(nx + pt_mark[i].nsize, ny - pt_mark[i].nsize,
-                                 nx + pt_mark[i].nsize, ny + pt_mark[i].nsize);
-                    qp->drawLine(nx + pt_mark[i].nsize, ny + pt_mark[i].nsize,
-                                 nx - pt_mark[i].nsize, ny + pt_mark[i].nsize);
-                    qp->drawLine(nx - pt_mark[i].nsize, ny + pt_mark[i].nsize,
-                                 nx - pt_mark[i].nsize, ny - pt_mark[i].nsize);
-                    break;
+                    std::size_t k = pt_direct[j];
+                    draw_symbol(qp, pm.symbol, pt_nx[k], pt_ny[k], pm.nsize);
                 }
+            }
+            pt_direct.clear();
+        };
+
+        pt_inst.clear();
+        pt_direct.clear();
+        for (std::size_t k = 0; k < pt_nx.size(); ++k)
+        {
+            std::uint32_t st = pt_vis_style[k];
+            if (st == no_style) continue;
+
+            if (pt_mode == pt_draw::sprites && pt_style_sprite[st] >= 0)
+            {
+                if (!pt_direct.empty()) draw_direct();
+                pt_inst.push_back(marker_inst{int(pt_nx[k]), int(pt_ny[k]),
+                                              pt_style_sprite[st]});
+            }
+            else
+            {
+                if (!pt_inst.empty())
+                {
+                    pt_atlas.draw(qp, pt_inst);
+                    pt_inst.clear();
                 }
+                pt_direct.push_back(k);
             }
         }
+        pt_atlas.draw(qp, pt_inst);
+        draw_direct();
     }
 
+    if (any_selected && !stop.stop_requested()) draw_selection(qp, cs, view);
+
     qp->restore();
 }
 
+void Coordsys_model::draw_ln_segments(QPainter* qp, Coordsys* cs, std::size_t i)
+{
+    // connect all points on each line (two transformations per vertex)
+    // non-finite vertices are gaps in the line
+    ln_view v = ln_vertices(i);
+    for (std::size_t j = 0; j + 1 < v.n; ++j)
+    {
+        if (!std::isfinite(v.xv(j)) || !std::isfinite(v.yv(j)) ||
+            !std::isfinite(v.xv(j + 1)) || !std::isfinite(v.yv(j + 1)))
+            continue;
+
+        int nx1 = cs->x.au_to_w(v.xv(j));
+        int ny1 = cs->y.au_to_w(v.yv(j));
+        int nx2 = cs->x.au_to_w(v.xv(j + 1));
+        int ny2 = cs->y.au_to_w(v.yv(j + 1));
+        qp->drawLine(nx1, ny1, nx2, ny2);
+    }
+}
+
+void Coordsys_model::draw_ln_polyline(QPainter* qp, const ln_prep& lp)
+{
+    // hand over each run of the line in chunks to keep the paths for the stroker
+    // bounded; consecutive chunks share their end vertex to stay connected
+    for (std::size_t r = 0; r < lp.runs.size(); ++r)
+    {
+        std::size_t begin = lp.runs[r];
+        std::size_t end = r + 1 < lp.runs.size() ? lp.runs[r + 1] : lp.pts.size();
+        for (std::size_t start = begin; start + 1 < end; start += ln_chunk - 1)
+        {
+            qp->drawPolyline(lp.pts.data() + start,
+                             int(std::min<std::size_t>(ln_chunk, end - start)));
+        }
+    }
+}
+
+void Coordsys_model::prepare_lns(Coordsys* cs, std::stop_token stop)
+{
+    // transformation, decimation and area paths of the lines in vis are
+    // independent of each other and are prepared on all threads of the pool
+    // (results in ln_preps in the order of vis; the buffers are reused)
+    double y0 = 0.0;
+    double ny0 = 0.0; // base line for areas
+    cs->y.au_to_w(std::span<const double>(&y0, 1), std::span<double>(&ny0, 1));
+
+    Thread_pool& pool = Thread_pool::global();
+    ln_tmps.resize(pool.size());
+    if (ln_preps.size() < vis.size()) ln_preps.resize(vis.size());
+
+    pool.parallel_for(vis.size(), ln_grain, [&](std::size_t begin, std::size_t end,
+                                                unsigned slot) {
+        if (stop.stop_requested()) return; // result is discarded anyway
+        for (std::size_t k = begin; k < end; ++k)
+        {
+            prepare_ln(cs, vis[k], ny0, ln_tmps[slot], ln_preps[k]);
+        }
+    });
+}
+
+void Coordsys_model::prepare_ln(Coordsys* cs, std::size_t i, double ny0, ln_tmp& t,
+                                ln_prep& lp) const
+{
+    // called concurrently for different lines: must not modify the model
+    const ln2d_mark& m = line_styles[line_style[i]];
+    ln_view v = ln_vertices(i);
+    std::size_t first = 0;
+    std::size_t last = v.n;
+
+    lp.pts.clear();
+    lp.runs.clear();
+    lp.area = QPainterPath();
+    lp.n_vertices = v.n;
+
+    // segments are transformed while drawing, only the area is prepared
+    if (ln_mode == ln_draw::segments && !m.mark_area) return;
+
+    // x-sorted lines: only the visible part plus one vertex on each side is needed
+    // and dense parts can be reduced to what is visible per pixel column
+    bool decimate = false;
+    if (ln_mode == ln_draw::polyline && line_sorted[i])
+    {
+        visible_ln_range(cs, v, first, last);
+        std::size_t ncols = cs->x.nmax() - cs->x.nmin();
+        decimate = last - first > m4_min_ratio * ncols;
+        lp.n_vertices = last - first;
+    }
+
+    transform_ln(cs, v, first, last, t);
+    fill_ln_pts(t, decimate, lp);
+
+    if (m.mark_area)
+    {
+        // one closed area per run of the line
+        QPainterPath& polyPath = lp.area;
+        for (std::size_t r = 0; r < lp.runs.size(); ++r)
+        {
+            std::size_t begin = lp.runs[r];
+            std::size_t end = r + 1 < lp.runs.size() ? lp.runs[r + 1] : lp.pts.size();
+
+            polyPath.moveTo(lp.pts[begin].x(), ny0);
+
+            // connect all points of the run
+            for (std::size_t j = begin; j < end; ++j)
+            {
+                polyPath.lineTo(lp.pts[j]);
+            }
+
+            polyPath.lineTo(lp.pts[end - 1].x(), ny0);
+            polyPath.closeSubpath();
+        }
+    }
+}
+
+void Coordsys_model::visible_ln_range(Coordsys* cs, const ln_view& v,
+                                      std::size_t& first, std::size_t& last) const
+{
+    // requires x values in ascending order
+    // returns [first, last) including one vertex left and right of the visible
+    // x range to connect to vertices outside of the cs area
+    double xmin = cs->x.min();
+    double xmax = cs->x.max();
+    if (cs->x.scaling() == axis_scal::logarithmic)
+    {
+        xmin = std::pow(10.0, xmin);
+        xmax = std::pow(10.0, xmax);
+    }
+
+    // binary searches for first x >= xmin and first x > xmax
+    first = ln_partition_point(v, 0, [xmin](double x) { return x < xmin; });
+    last = ln_partition_point(v, first, [xmax](double x) { return x <= xmax; });
+
+    if (first > 0) --first;
+    if (last < v.n) ++last;
+}
+
+void Coordsys_model::transform_ln(Coordsys* cs, const ln_view& v, std::size_t first,
+                                  std::size_t last, ln_tmp& t) const
+{
+    // transform each vertex of [first, last) exactly once as whole columns
+    // (directly from the columns of the line if not interleaved)
+    // (buffer capacities are kept between calls)
+    std::size_t n = last - first;
+    t.xs.resize(n);
+    t.ys.resize(n);
+    if (!v.pts)
+    {
+        cs->x.au_to_w(std::span(v.x + first, n), t.xs);
+        cs->y.au_to_w(std::span(v.y + first, n), t.ys);
+    }
+    else
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            t.xs[j] = v.xv(first + j);
+            t.ys[j] = v.yv(first + j);
+        }
+        cs->x.au_to_w(t.xs, t.xs);
+        cs->y.au_to_w(t.ys, t.ys);
+    }
+}
+
+void Coordsys_model::fill_ln_pts(const ln_tmp& t, bool decimate, ln_prep& lp) const
+{
+    // fill lp.pts from the transformed columns t.xs, t.ys
+    // non-finite vertices (e.g. nan as gap marker in data) split the line into
+    // runs of finite vertices, which are drawn separately
+    const std::vector<double>& xs = t.xs;
+    const std::vector<double>& ys = t.ys;
+    std::size_t n = xs.size();
+    std::vector<QPointF>& pts = lp.pts;
+
+    pts.clear();
+    lp.runs.clear();
+
+    auto finite = [&](std::size_t j) { return std::isfinite(xs[j]) && std::isfinite(ys[j]); };
+
+    std::size_t b = 0;
+    while (b < n)
+    {
+        if (!finite(b))
+        {
+            ++b;
+            continue;
+        }
+        std::size_t e = b + 1;
+        while (e < n && finite(e)) ++e;
+
+        lp.runs.push_back(pts.size());
+        if (decimate)
+        {
+            m4_decimate(xs, ys, b, e, pts);
+        }
+        else
+        {
+            for (std::size_t j = b; j < e; ++j)
+            {
+                pts.emplace_back(xs[j], ys[j]);
+            }
+        }
+        b = e;
+    }
+}
+
+void Coordsys_model::m4_decimate(const std::vector<double>& xs,
+                                 const std::vector<double>& ys, std::size_t b,
+                                 std::size_t e, std::vector<QPointF>& pts)
+{
+    // m4 decimation of [b, e) (requires ascending x values):
+    // keep first, min, max and last vertex of each pixel column in their original
+    // order. The rasterized line is the same, since all vertical extents within
+    // each column and all connections between neighbouring columns are kept.
+    std::size_t i = b;
+    while (i < e)
+    {
+        double col = std::floor(xs[i]);
+        std::size_t imin = i;
+        std::size_t imax = i;
+        std::size_t j = i + 1;
+        for (; j < e && std::floor(xs[j]) == col; ++j)
+        {
+            if (ys[j] < ys[imin]) imin = j;
+            if (ys[j] > ys[imax]) imax = j;
+        }
+
+        std::size_t idx[4] = {i, std::min(imin, imax), std::max(imin, imax), j - 1};
+        for (int k = 0; k < 4; ++k)
+        {
+            if (k == 0 || idx[k] != idx[k - 1])
+            {
+                pts.emplace_back(xs[idx[k]], ys[idx[k]]);
+            }
+        }
+        i = j;
+    }
+}
+
+bbox2d Coordsys_model::view_box(Coordsys* cs) const
+{
+    // visible area of cs extended by the max. size of marks, converted to
+    // unscaled model coordinates (y grows downwards on the paint device)
+    int m = std::ceil(max_mark_px);
+    double x1 = cs->x.w_to_au(cs->x.nmin() - m);
+    double x2 = cs->x.w_to_au(cs->x.nmax() + m);
+    double y1 = cs->y.w_to_au(cs->y.nmin() + m);
+    double y2 = cs->y.w_to_au(cs->y.nmax() - m);
+
+    bbox2d b;
+    b.xmin = std::min(x1, x2);
+    b.xmax = std::max(x1, x2);
+    b.ymin = std::min(y1, y2);
+    b.ymax = std::max(y1, y2);
+    return b;
+}
+
+void Coordsys_model::update_max_mark_px(const QPen& pen, int nsize)
+{
+    max_mark_px = std::max(max_mark_px, nsize + pen.widthF());
+}
+
+template <typename Style_of>
+void Coordsys_model::style_runs(const std::vector<std::size_t>& items, Style_of style_of)
+{
+    // runs of consecutive items with the same style in O(items), the order of
+    // the items is kept (it is the z-order of overlapping items)
+    // bucket[r] .. bucket[r + 1] is the range of run r in items
+    bucket.clear();
+    for (std::size_t k = 0; k < items.size(); ++k)
+    {
+        if (k == 0 || style_of(items[k]) != style_of(items[k - 1])) bucket.push_back(k);
+    }
+    bucket.push_back(items.size());
+}
+
+void Coordsys_model::set_pt_draw(pt_draw mode)
+{
+    modify();
+    pt_mode = mode;
+}
+
+void Coordsys_model::set_ln_draw(ln_draw mode)
+{
+    modify();
+    ln_mode = mode;
+}
+
 [[maybe_unused]] int Coordsys_model::add_p(const pt2d& p_in,
-                                           const pt2d_mark m)
+                                           const pt2d_mark& m)
 {
+    modify();
 
-    pt.push_back(p_in);
-    pt_mark.push_back(m);
+    int id = unique_id;
+    push_pt(p_in, pt_style_idx(m), -1);
 
-    mark_id new_id;
-    new_id.id = unique_id++;
-    pt_id.push_back(new_id);
+    return id;
+}
 
-    return new_id.id;
+[[maybe_unused]] int Coordsys_model::add_p(std::span<const pt2d> vp_in,
+                                           const pt2d_mark& m)
+{
+    modify();
+
+    int id = unique_id;
+    std::uint32_t style = pt_style_idx(m);
+
+    pt_x.reserve(pt_x.size() + vp_in.size());
+    pt_y.reserve(pt_y.size() + vp_in.size());
+    for (const pt2d& p : vp_in)
+    {
+        push_pt(p, style, -1);
+    }
+
+    return id;
 }
 
 //
 // hint: using ln2d = std::vector<pt2d>;
 //
 [[maybe_unused]] int Coordsys_model::add_l(const ln2d& vp_in,
-                                           const ln2d_mark m)
+                                           const ln2d_mark& m)
 {
+    return add_l(std::span<const pt2d>(vp_in), m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l(std::span<const pt2d> vp_in,
+                                           const ln2d_mark& m)
+{
+    // append the vertices to the arena (amortized growth of the columns)
+    ln_ref r{ln_store::arena, line_x.size(), vp_in.size(), {}};
+    for (const pt2d& p : vp_in)
+    {
+        line_x.push_back(p.x);
+        line_y.push_back(p.y);
+    }
+    return push_ln(r, m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l(std::span<const double> x_in,
+                                           std::span<const double> y_in,
+                                           const ln2d_mark& m)
+{
+    if (x_in.size() != y_in.size())
+        throw std::runtime_error("add_l: x and y values must have the same size.");
+
+    ln_ref r{ln_store::arena, line_x.size(), x_in.size(), {}};
+    line_x.insert(line_x.end(), x_in.begin(), x_in.end());
+    line_y.insert(line_y.end(), y_in.begin(), y_in.end());
+    return push_ln(r, m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l(ln2d&& vp_in, const ln2d_mark& m)
+{
+    ln_ref r{ln_store::adopted, line_adopted.size(), vp_in.size(), {}};
+    line_adopted.push_back(std::move(vp_in));
+    return push_ln(r, m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l(std::shared_ptr<const std::vector<double>> x_in,
+                                           std::shared_ptr<const std::vector<double>> y_in,
+                                           const ln2d_mark& m)
+{
+    if (!x_in || !y_in || x_in->size() != y_in->size())
+        throw std::runtime_error("add_l: x and y values must have the same size.");
 
-    // the separate copy should not be needed, since it is done in push_back
-    // anyway
-    //
-    // std::vector<pt2d> v;
-    // std::copy(vp_in.begin(), vp_in.end(), std::back_inserter(v));
-    //
-    line.push_back(vp_in);
-    line_mark.push_back(m);
+    ln_ref r{ln_store::shared, line_shared.size(), x_in->size(), {}};
+    line_shared.push_back(ln_cols{std::move(x_in), std::move(y_in)});
+    return push_ln(r, m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l_view(std::span<const pt2d> vp_in,
+                                                const ln2d_mark& m)
+{
+    ln_ref r{ln_store::external, 0, vp_in.size(), {}};
+    r.ext = ln_view{nullptr, nullptr, vp_in.data(), vp_in.size()};
+    return push_ln(r, m);
+}
+
+[[maybe_unused]] int Coordsys_model::add_l_view(std::span<const double> x_in,
+                                                std::span<const double> y_in,
+                                                const ln2d_mark& m)
+{
+    if (x_in.size() != y_in.size())
+        throw std::runtime_error("add_l_view: x and y values must have the same size.");
+
+    ln_ref r{ln_store::external, 0, x_in.size(), {}};
+    r.ext = ln_view{x_in.data(), y_in.data(), nullptr, x_in.size()};
+    return push_ln(r, m);
+}
+
+ln_view Coordsys_model::ln_vertices(std::size_t i) const
+{
+    const ln_ref& r = line_ref[i];
+    switch (r.store)
+    {
+    case ln_store::arena:
+        return ln_view{line_x.data() + r.pos, line_y.data() + r.pos, nullptr, r.n};
+    case ln_store::adopted:
+    {
+        const ln2d& l = line_adopted[r.pos];
+        return ln_view{nullptr, nullptr, l.data(), r.n};
+    }
+    case ln_store::shared:
+    {
+        const ln_cols& c = line_shared[r.pos];
+        return ln_view{c.x->data(), c.y->data(), nullptr, r.n};
+    }
+    case ln_store::external:
+        break;
+    }
+    return r.ext;
+}
+
+int Coordsys_model::push_ln(const ln_ref& r, const ln2d_mark& m)
+{
+    // common part of all add_l variants: the vertices are already in place
+    modify();
+
+    std::size_t i = n_lines();
+    line_ref.push_back(r);
+
+    ln_view v = ln_vertices(i);
+    line_grid.insert(i, ln_box(v));
+    update_max_mark_px(m.pen, 0);
+
+    line_style.push_back(line_style_idx(m));
+    line_sorted.push_back(ln_x_sorted(v));
+    line_selected.push_back(false);
+    grps[line_style_grp[line_style.back()]].lines.push_back(i);
 
     mark_id new_id;
     new_id.id = unique_id++;
     line_id.push_back(new_id);
 
     if (m.mark_pts == true)
-    { // add points of line to pts marked in model
+    { // mark points of line in model
+      // (the vertices are referenced, but each mark gets its own id)
 
-        for (int i = 0; i < vp_in.size(); i += m.delta)
-        {
-
-            pt.push_back(vp_in[i]);
-            pt_mark.push_back(m.pm);
-
-            mark_id new_pt_id;
-            new_pt_id.id = unique_id++;
-            new_pt_id.linked_to_id = new_id.id;
-            pt_id.push_back(new_pt_id);
-        }
+        int delta = std::max(m.delta, 1);
+        int n_marks = int((v.n + delta - 1) / delta);
+        line_pt_marks.push_back(
+            ln_pt_marks{i, delta, pt_style_idx(m.pm), unique_id, n_marks});
+        unique_id += n_marks;
     }
 
     return new_id.id;
 }
 
 [[maybe_unused]] int Coordsys_model::add_v(const vec2d& v_in,
-                                           const vec2d_mark m)
+                                           const vec2d_mark& m)
 {
+    modify();
 
+    vec_grid.insert(vec.size(),
+                    bbox2d{std::min(v_in.from.x, v_in.to.x), std::max(v_in.from.x, v_in.to.x),
+                           std::min(v_in.from.y, v_in.to.y), std::max(v_in.from.y, v_in.to.y)});
+    update_max_mark_px(m.pen, 0);
+
+    std::uint32_t style = vec_style_idx(m);
+    grps[vec_style_grp[style]].vecs.push_back(vec.size());
     vec.push_back(v_in);
-    vec_mark.push_back(m);
+    vec_style.push_back(style);
+    vec_selected.push_back(false);
 
     mark_id new_id;
     new_id.id = unique_id++;
@@ -189,6 +774,542 @@ void Coordsys_model::draw(QPainter* qp, Coordsys* cs)
     return new_id.id;
 }
 
+[[maybe_unused]] int Coordsys_model::add_stream(std::size_t capacity,
+                                                const ln2d_mark& m)
+{
+    modify();
+
+    // no entry in line_grid: the extent of a stream changes all the time
+    update_max_mark_px(m.pen, 0);
+
+    int id = unique_id++;
+    streams.push_back(stream_item{Ring_series(capacity), line_style_idx(m), id});
+    return id;
+}
+
+Ring_series& Coordsys_model::stream(int id)
+{
+    for (stream_item& s : streams)
+    {
+        if (s.id == id) return s.buf;
+    }
+    throw std::runtime_error("Coordsys_model: no stream with id " + std::to_string(id));
+}
+
+bool Coordsys_model::streams_appended(const stream_state& drawn) const
+{
+    for (std::size_t k = 0; k < streams.size(); ++k)
+    {
+        std::uint64_t d = k < drawn.size() ? drawn[k] : 0;
+        if (streams[k].buf.total() != d) return true;
+    }
+    return false;
+}
+
+bool Coordsys_model::streams_last_x(double& x) const
+{
+    bool found = false;
+    for (const stream_item& s : streams)
+    {
+        double xs;
+        if (s.buf.last_x(xs))
+        {
+            x = found ? std::max(x, xs) : xs;
+            found = true;
+        }
+    }
+    return found;
+}
+
+std::uint64_t Coordsys_model::streams_epoch() const
+{
+    // first() only grows with each clear of a stream
+    std::uint64_t epoch = 0;
+    for (const stream_item& s : streams)
+    {
+        epoch += s.buf.first();
+    }
+    return epoch;
+}
+
+void Coordsys_model::draw_streams(QPainter* qp, Coordsys* cs, stream_state* drawn)
+{
+    // all available samples of each stream
+    if (drawn != nullptr) drawn->assign(streams.size(), 0);
+
+    for (std::size_t k = 0; k < streams.size(); ++k)
+    {
+        std::uint64_t upto;
+        draw_stream(qp, cs, streams[k], 0, upto, stream_x, stream_y, stream_pts);
+        if (drawn != nullptr) (*drawn)[k] = upto;
+    }
+}
+
+void Coordsys_model::draw_appended(QPainter* qp, Coordsys* cs, stream_state& drawn) const
+{
+    // own buffers: might run concurrently to draw() of a render thread
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<QPointF> pts;
+
+    drawn.resize(streams.size(), 0);
+    for (std::size_t k = 0; k < streams.size(); ++k)
+    {
+        if (streams[k].buf.total() == drawn[k]) continue;
+
+        // start at the last sample drawn before to stay connected
+        std::uint64_t from = drawn[k] > 0 ? drawn[k] - 1 : 0;
+        draw_stream(qp, cs, streams[k], from, drawn[k], x, y, pts);
+    }
+}
+
+void Coordsys_model::draw_stream(QPainter* qp, Coordsys* cs, const stream_item& s,
+                                 std::uint64_t from, std::uint64_t& upto,
+                                 std::vector<double>& x, std::vector<double>& y,
+                                 std::vector<QPointF>& pts) const
+{
+    // draw samples [from, total) of s that are still available, upto returns the
+    // end of the samples drawn
+    if (grps[line_style_grp[s.style]].hidden)
+    {
+        upto = s.buf.total();
+        return;
+    }
+    std::uint64_t first = s.buf.copy_since(from, x, y);
+    upto = first + x.size();
+
+    cs->x.au_to_w(x, x);
+    cs->y.au_to_w(y, y);
+    pts.resize(x.size());
+    for (std::size_t j = 0; j < x.size(); ++j)
+    {
+        pts[j] = QPointF(x[j], y[j]);
+    }
+
+    qp->save();
+    qp->setPen(line_styles[s.style].pen);
+    int n = pts.size();
+    for (int start = 0; start + 1 < n; start += ln_chunk - 1)
+    {
+        qp->drawPolyline(pts.data() + start, std::min(ln_chunk, n - start));
+    }
+    qp->restore();
+}
+
+std::uint32_t Coordsys_model::pt_style_idx(const pt2d_mark& m)
+{
+    std::uint32_t style = pt_styles.intern(m);
+    if (style == pt_style_sprite.size())
+    { // new style
+        pt_style_sprite.push_back(pt_atlas.sprite(m));
+        pt_style_grp.push_back(grp_idx(m.grp));
+        update_max_mark_px(m.pen, m.nsize);
+    }
+    return style;
+}
+
+std::uint32_t Coordsys_model::line_style_idx(const ln2d_mark& m)
+{
+    std::uint32_t style = line_styles.intern(m);
+    if (style == line_style_grp.size()) line_style_grp.push_back(grp_idx(m.grp));
+    return style;
+}
+
+std::uint32_t Coordsys_model::vec_style_idx(const vec2d_mark& m)
+{
+    std::uint32_t style = vec_styles.intern(m);
+    if (style == vec_style_grp.size()) vec_style_grp.push_back(grp_idx(m.grp));
+    return style;
+}
+
+std::uint32_t Coordsys_model::grp_idx(int grp)
+{
+    auto [it, is_new] = grp_index.try_emplace(grp, grps.size());
+    if (is_new)
+    {
+        grps.emplace_back();
+        grps.back().grp = grp;
+    }
+    return it->second;
+}
+
+void Coordsys_model::push_pt(const pt2d& p, std::uint32_t style, int linked_to_id)
+{
+    std::size_t i = pt_x.size();
+    int id = unique_id++;
+
+    pt_x.push_back(p.x);
+    pt_y.push_back(p.y);
+    pt_grid.insert(i, pt_x, pt_y);
+    pt_style.push_back(style);
+    pt_active.push_back(true);
+    pt_selected.push_back(false);
+    grps[pt_style_grp[style]].pts.push_back(i);
+
+    // extend the last run of ids if possible
+    if (pt_id_runs.empty() || pt_id_runs.back().linked_to_id != linked_to_id ||
+        pt_id_runs.back().first_id + int(i - pt_id_runs.back().first) != id)
+    {
+        pt_id_runs.push_back(pt_id_run{i, id, linked_to_id});
+    }
+}
+
+int Coordsys_model::pt_id(std::size_t i) const
+{
+    auto run = std::upper_bound(pt_id_runs.begin(), pt_id_runs.end(), i,
+                                [](std::size_t idx, const pt_id_run& run) {
+                                    return idx < run.first;
+                                }) -
+               1;
+    return run->first_id + int(i - run->first);
+}
+
+template <typename Fn>
+void Coordsys_model::for_ids(int first_id, int last_id, Fn fn) const
+{
+    // ids are assigned in ascending order within each kind of item
+    for (std::size_t r = 0; r < pt_id_runs.size(); ++r)
+    {
+        const pt_id_run& run = pt_id_runs[r];
+        std::size_t end = r + 1 < pt_id_runs.size() ? pt_id_runs[r + 1].first : pt_x.size();
+        int lo = std::max(first_id, run.first_id);
+        int hi = std::min<int>(last_id, run.first_id + int(end - run.first) - 1);
+        for (int id = lo; id <= hi; ++id)
+        {
+            fn(item_kind::pt, run.first + (id - run.first_id));
+        }
+    }
+
+    auto by_id = [](const mark_id& m, int id) { return m.id < id; };
+    for (auto it = std::lower_bound(line_id.begin(), line_id.end(), first_id, by_id);
+         it != line_id.end() && it->id <= last_id; ++it)
+    {
+        fn(item_kind::line, std::size_t(it - line_id.begin()));
+    }
+    for (auto it = std::lower_bound(vec_id.begin(), vec_id.end(), first_id, by_id);
+         it != vec_id.end() && it->id <= last_id; ++it)
+    {
+        fn(item_kind::vec, std::size_t(it - vec_id.begin()));
+    }
+
+    // marked line vertices have ids of their own, but share the state of their
+    // line (line_pt_marks is in ascending order of ids)
+    for (const ln_pt_marks& r : line_pt_marks)
+    {
+        if (r.first_id > last_id) break;
+        if (r.first_id + r.n_marks > first_id) fn(item_kind::line, r.line);
+    }
+}
+
+void Coordsys_model::set_group_visible(int grp, bool visible)
+{
+    auto it = grp_index.find(grp);
+    if (it == grp_index.end() || grps[it->second].hidden == !visible) return;
+
+    modify();
+    grps[it->second].hidden = !visible;
+}
+
+bool Coordsys_model::group_visible(int grp) const
+{
+    auto it = grp_index.find(grp);
+    return it == grp_index.end() || !grps[it->second].hidden;
+}
+
+std::vector<int> Coordsys_model::group_ids(int grp) const
+{
+    std::vector<int> ids;
+    auto it = grp_index.find(grp);
+    if (it == grp_index.end()) return ids;
+
+    const grp_data& g = grps[it->second];
+    ids.reserve(g.pts.size() + g.lines.size() + g.vecs.size());
+    for (std::size_t i : g.pts)
+    {
+        ids.push_back(pt_id(i));
+    }
+    for (std::size_t i : g.lines)
+    {
+        ids.push_back(line_id[i].id);
+    }
+    for (std::size_t i : g.vecs)
+    {
+        ids.push_back(vec_id[i].id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void Coordsys_model::set_active(int first_id, int last_id, bool active)
+{
+    modify();
+
+    for_ids(first_id, last_id, [&](item_kind kind, std::size_t i) {
+        switch (kind)
+        {
+            case item_kind::pt:
+                pt_active[i] = active;
+                break;
+            case item_kind::line:
+                line_id[i].active = active;
+                break;
+            case item_kind::vec:
+                vec_id[i].active = active;
+                break;
+        }
+    });
+}
+
+void Coordsys_model::select_group(int grp, bool selected)
+{
+    auto it = grp_index.find(grp);
+    if (it == grp_index.end()) return;
+
+    modify();
+    grps[it->second].selected = selected;
+    if (selected) any_selected = true;
+}
+
+void Coordsys_model::select(int first_id, int last_id, bool selected)
+{
+    modify();
+    if (selected) any_selected = true;
+    for_ids(first_id, last_id, [&](item_kind kind, std::size_t i) {
+        switch (kind)
+        {
+            case item_kind::pt:
+                pt_selected[i] = selected;
+                break;
+            case item_kind::line:
+                line_selected[i] = selected;
+                break;
+            case item_kind::vec:
+                vec_selected[i] = selected;
+                break;
+        }
+    });
+}
+
+void Coordsys_model::clear_selection()
+{
+    modify();
+    any_selected = false;
+    for (grp_data& g : grps)
+    {
+        g.selected = false;
+    }
+    pt_selected.assign(pt_selected.size(), false);
+    line_selected.assign(line_selected.size(), false);
+    vec_selected.assign(vec_selected.size(), false);
+}
+
+std::vector<int> Coordsys_model::selected_ids() const
+{
+    std::vector<int> ids;
+    for (std::size_t r = 0; r < pt_id_runs.size(); ++r)
+    {
+        const pt_id_run& run = pt_id_runs[r];
+        std::size_t end = r + 1 < pt_id_runs.size() ? pt_id_runs[r + 1].first : pt_x.size();
+        for (std::size_t i = run.first; i < end; ++i)
+        {
+            if (pt_is_selected(i))
+                ids.push_back(run.first_id + int(i - run.first));
+        }
+    }
+    for (std::size_t i = 0; i < line_id.size(); ++i)
+    {
+        if (line_is_selected(i))
+            ids.push_back(line_id[i].id);
+    }
+    for (std::size_t i = 0; i < vec_id.size(); ++i)
+    {
+        if (vec_is_selected(i))
+            ids.push_back(vec_id[i].id);
+    }
+    for (const ln_pt_marks& r : line_pt_marks)
+    {
+        if (!line_is_selected(r.line)) continue;
+        for (int k = 0; k < r.n_marks; ++k)
+        {
+            ids.push_back(r.first_id + k);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void Coordsys_model::draw_selection(QPainter* qp, Coordsys* cs, const bbox2d& view)
+{
+    // visible selected items are drawn again with the select pen on top
+    qp->setPen(cs->style().theme.select_pen);
+    qp->setBrush(Qt::NoBrush);
+
+    vec_grid.query(view, vis);
+    vec_buf.clear();
+    for (std::size_t i : vis)
+    {
+        if (vec_hidden(i) || !vec_is_selected(i)) continue;
+        vec_buf.emplace_back(cs->x.au_to_w(vec[i].from.x), cs->y.au_to_w(vec[i].from.y),
+                             cs->x.au_to_w(vec[i].to.x), cs->y.au_to_w(vec[i].to.y));
+    }
+    if (!vec_buf.empty()) qp->drawLines(vec_buf.data(), vec_buf.size());
+
+    line_grid.query(view, vis);
+    ln_tmp t;
+    ln_prep lp;
+    for (std::size_t i : vis)
+    {
+        if (line_hidden(i) || !line_is_selected(i)) continue;
+        ln_view v = ln_vertices(i);
+        std::size_t first = 0;
+        std::size_t last = v.n;
+        if (line_sorted[i]) visible_ln_range(cs, v, first, last);
+        transform_ln(cs, v, first, last, t);
+        fill_ln_pts(t, false, lp);
+        draw_ln_polyline(qp, lp);
+    }
+
+    pt_grid.query(view, pt_x, pt_y, vis);
+    for (std::size_t i : vis)
+    {
+        if (pt_hidden(i) || !pt_is_selected(i)) continue;
+        int r = pt_styles[pt_style[i]].nsize / 2 + 3; // around the mark
+        qp->drawEllipse(QPoint(cs->x.au_to_w(pt_x[i]), cs->y.au_to_w(pt_y[i])), r, r);
+    }
+}
+
+static double to_scaled(double v, axis_scal scal)
+{
+    // non-positive values on logarithmic axes become non-finite (not pickable)
+    return scal == axis_scal::logarithmic ? std::log10(v) : v;
+}
+
+void Coordsys_model::modify()
+{
+    // the pick tree being built reads the model
+    pick_next.reset();
+    m_version = new_version_stamp();
+}
+
+std::shared_ptr<const Coordsys_model::pick_index>
+Coordsys_model::build_pick_index(axis_scal xscal, axis_scal yscal) const
+{
+    auto pi = std::make_shared<pick_index>();
+    pi->version = m_version;
+    pi->xscal = xscal;
+    pi->yscal = yscal;
+    pi->n_pts = pt_x.size();
+    pi->ln_first.resize(n_lines() + 1);
+    pi->ln_first[0] = 0;
+    for (std::size_t i = 0; i < n_lines(); ++i)
+    {
+        pi->ln_first[i + 1] = pi->ln_first[i] + line_ref[i].n;
+    }
+
+    std::vector<kd_item> items;
+    items.reserve(pi->n_pts + pi->ln_first.back());
+    for (std::size_t i = 0; i < pi->n_pts; ++i)
+    {
+        if (pt_hidden(i)) continue;
+        items.push_back(kd_item{to_scaled(pt_x[i], xscal), to_scaled(pt_y[i], yscal), i});
+    }
+    for (std::size_t i = 0; i < n_lines(); ++i)
+    {
+        if (line_hidden(i)) continue;
+        ln_view v = ln_vertices(i);
+        for (std::size_t j = 0; j < v.n; ++j)
+        {
+            items.push_back(kd_item{to_scaled(v.xv(j), xscal), to_scaled(v.yv(j), yscal),
+                                    pi->n_pts + pi->ln_first[i] + j});
+        }
+    }
+    pi->tree.build(std::move(items));
+    return pi;
+}
+
+bool Coordsys_model::pick(Coordsys* cs, int nx, int ny, int tol, pick_result& r)
+{
+    axis_scal xscal = cs->x.scaling();
+    axis_scal yscal = cs->y.scaling();
+
+    if (pick_next.f.valid() &&
+        pick_next.f.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        pick_idx = pick_next.f.get();
+    }
+    if (!pick_idx || pick_idx->version != m_version || pick_idx->xscal != xscal ||
+        pick_idx->yscal != yscal)
+    {
+        // nothing is picked until the tree of the current model is ready (a tree
+        // of an outdated model is finished first)
+        if (!pick_next.f.valid())
+        {
+            pick_next.f = std::async(std::launch::async, [this, xscal, yscal] {
+                return build_pick_index(xscal, yscal);
+            });
+        }
+        return false;
+    }
+    const pick_index& pi = *pick_idx;
+
+    // the tree is queried in pixels: weights are pixels per scaled axis unit
+    double qx = cs->x.w_to_a(nx);
+    double qy = cs->y.w_to_a(ny);
+    double wx = 1.0 / std::abs(cs->x.w_to_a(nx + 1) - qx);
+    double wy = 1.0 / std::abs(cs->y.w_to_a(ny + 1) - qy);
+
+    kd_item found;
+    double d;
+    if (!pi.tree.nearest(qx, qy, wx, wy, tol, found, d)) return false;
+
+    r = pick_result{};
+    r.dist = d;
+    if (found.idx < pi.n_pts)
+    {
+        std::size_t i = found.idx;
+        auto run = std::upper_bound(pt_id_runs.begin(), pt_id_runs.end(), i,
+                                    [](std::size_t idx, const pt_id_run& run) {
+                                        return idx < run.first;
+                                    }) -
+                   1;
+        r.is_point = true;
+        r.id = pt_id(i);
+        r.linked_to_id = run->linked_to_id;
+        r.grp = pt_styles[pt_style[i]].grp;
+        r.p = pt2d(pt_x[i], pt_y[i]);
+        return true;
+    }
+
+    std::size_t k = found.idx - pi.n_pts;
+    std::size_t i = std::upper_bound(pi.ln_first.begin(), pi.ln_first.end(), k) -
+                    pi.ln_first.begin() - 1;
+    std::size_t j = k - pi.ln_first[i];
+    ln_view v = ln_vertices(i);
+    r.vertex = j;
+    r.p = pt2d(v.xv(j), v.yv(j));
+
+    // marked vertices are reported as the point marking them
+    auto marks = std::lower_bound(line_pt_marks.begin(), line_pt_marks.end(), i,
+                                  [](const ln_pt_marks& m, std::size_t line) {
+                                      return m.line < line;
+                                  });
+    if (marks != line_pt_marks.end() && marks->line == i && j % marks->delta == 0 &&
+        !grps[pt_style_grp[marks->style]].hidden)
+    {
+        r.is_point = true;
+        r.id = marks->first_id + int(j / marks->delta);
+        r.linked_to_id = line_id[i].id;
+        r.grp = pt_styles[marks->style].grp;
+    }
+    else
+    {
+        r.is_point = false;
+        r.id = line_id[i].id;
+        r.grp = line_styles[line_style[i]].grp;
+    }
+    return true;
+}
+
 void Coordsys_model::set_label(const std::string& new_label)
 {
 
@@ -197,15 +1318,51 @@ void Coordsys_model::set_label(const std::string& new_label)
 
 void Coordsys_model::clear()
 {
+    modify();
     unique_id = 0;
 
-    pt.clear();
-    pt_mark.clear();
-    pt_id.clear();
+    pt_x.clear();
+    pt_y.clear();
+    pt_style.clear();
+    pt_active.clear();
+    pt_styles.clear();
+    pt_style_sprite.clear();
+    pt_id_runs.clear();
+    pt_atlas.clear();
+    pt_selected.clear();
+    any_selected = false;
 
-    line.clear();
-    line_mark.clear();
+    line_x.clear();
+    line_y.clear();
+    line_adopted.clear();
+    line_shared.clear();
+    line_ref.clear();
+    line_pt_marks.clear();
+    line_style.clear();
+    line_styles.clear();
     line_id.clear();
+    line_sorted.clear();
+    line_selected.clear();
+
+    vec.clear();
+    vec_style.clear();
+    vec_styles.clear();
+    vec_id.clear();
+    vec_selected.clear();
+
+    grps.clear();
+    grp_index.clear();
+    pt_style_grp.clear();
+    line_style_grp.clear();
+    vec_style_grp.clear();
+
+    streams.clear();
+
+    pt_grid.clear();
+    line_grid.clear();
+    vec_grid.clear();
+    max_mark_px = 0.0;
+    pick_idx.reset();
 
     m_label.clear();
 }
\ No newline at end of file
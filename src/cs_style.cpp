@@ -0,0 +1,21 @@
+#include "cs_style.hpp"
+#include "coordsys.hpp" // new_version_stamp
+
+static QFont resolve_font(const QString& family, int size, QFont::Weight weight)
+{
+    QFont f(family, size, weight);
+    // fall back to a sans serif font if family is not available
+    f.setStyleHint(QFont::SansSerif);
+    return f;
+}
+
+cs_style::cs_style(const cs_theme& t) :
+    theme{t}, notch_font{resolve_font(t.font_family, t.notch_font_size, QFont::Normal)},
+    label_font{resolve_font(t.font_family, t.label_font_size, QFont::Bold)},
+    log_font{resolve_font(t.font_family, t.label_font_size, QFont::Normal)},
+    title_font{resolve_font(t.font_family, t.title_font_size, QFont::Bold)},
+    notch_fm{notch_font}, label_fm{label_font}, log_fm{log_font}, title_fm{title_font},
+    log_x_advance{log_fm.horizontalAdvance(QString("log10(x)"))},
+    log_y_advance{log_fm.horizontalAdvance(QString("log10(y)"))}, id{new_version_stamp()}
+{
+}
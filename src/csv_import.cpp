@@ -0,0 +1,257 @@
+#include "csv_import.hpp"
+#include "thread_pool.hpp"
+
+#include <QFile>
+
+#include <algorithm> // std::max, std::count
+#include <charconv>  // std::from_chars
+#include <cmath>     // NAN
+#include <cstring>   // std::memchr
+#include <memory>    // std::make_shared
+#include <stdexcept>
+
+// smaller chunks are not worth the overhead of handing them to the pool
+static constexpr std::size_t min_chunk_size = 1 << 16;
+
+// remove white space, carriage returns and enclosing quotes
+static std::string_view trim(std::string_view f)
+{
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (!f.empty() && is_space(f.front())) f.remove_prefix(1);
+    while (!f.empty() && is_space(f.back())) f.remove_suffix(1);
+    if (f.size() >= 2 && f.front() == '"' && f.back() == '"') {
+        f = f.substr(1, f.size() - 2);
+    }
+    return f;
+}
+
+// false if f is not empty and no number
+static bool to_double(std::string_view f, double& v)
+{
+    f = trim(f);
+    v = NAN;
+    if (f.empty()) return true;
+    if (f.front() == '+') f.remove_prefix(1); // not accepted by from_chars
+
+    double d;
+    auto [ptr, ec] = std::from_chars(f.data(), f.data() + f.size(), d);
+    if (ec != std::errc() || ptr != f.data() + f.size()) return false;
+    v = d;
+    return true;
+}
+
+// next line starting at pos (w/o line end), pos is moved to the next line
+static std::string_view next_line(std::string_view text, std::size_t& pos)
+{
+    const char* begin = text.data() + pos;
+    const void* nl = std::memchr(begin, '\n', text.size() - pos);
+    std::size_t len = nl ? static_cast<const char*>(nl) - begin : text.size() - pos;
+    pos += nl ? len + 1 : len;
+    return std::string_view(begin, len);
+}
+
+static bool is_data_line(std::string_view line)
+{
+    line = trim(line);
+    return !line.empty() && line.front() != '#';
+}
+
+// call fn(col, field) for all fields of line (a space as delimiter also
+// stands for runs of spaces and tabs)
+template <typename Fn>
+static void for_each_field(std::string_view line, char delim, Fn fn)
+{
+    if (delim == ' ') {
+        int col = 0;
+        std::size_t i = 0;
+        while (true) {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+                ++i;
+            if (i == line.size()) return;
+            std::size_t j = i;
+            while (j < line.size() && line[j] != ' ' && line[j] != '\t' && line[j] != '\r')
+                ++j;
+            fn(col++, line.substr(i, j - i));
+            i = j;
+        }
+    }
+
+    int col = 0;
+    std::size_t i = 0;
+    while (true) {
+        std::size_t j = line.find(delim, i);
+        if (j == std::string_view::npos) {
+            fn(col, line.substr(i));
+            return;
+        }
+        fn(col++, line.substr(i, j - i));
+        i = j + 1;
+    }
+}
+
+static char detect_delimiter(std::string_view line)
+{
+    // most frequent candidate of the first line, space if there is none
+    char best = ' ';
+    std::ptrdiff_t n_best = 0;
+    for (char c : {',', ';', '\t'}) {
+        std::ptrdiff_t n = std::count(line.begin(), line.end(), c);
+        if (n > n_best) {
+            best = c;
+            n_best = n;
+        }
+    }
+    return best;
+}
+
+csv_table parse_csv(std::string_view text, const csv_options& opt)
+{
+    csv_table t;
+
+    // skip utf-8 byte order mark
+    if (text.starts_with("\xEF\xBB\xBF")) text.remove_prefix(3);
+
+    // first data line: delimiter, number of columns and header
+    std::size_t pos = 0;
+    std::string_view first;
+    std::size_t first_pos = 0;
+    while (pos < text.size()) {
+        first_pos = pos;
+        first = next_line(text, pos);
+        if (is_data_line(first)) break;
+        first = std::string_view();
+    }
+    if (first.empty()) return t; // no data at all
+
+    char delim = opt.delimiter ? opt.delimiter : detect_delimiter(first);
+
+    std::vector<std::string_view> first_fields;
+    for_each_field(first, delim,
+                   [&](int, std::string_view f) { first_fields.push_back(trim(f)); });
+    int n_cols = first_fields.size();
+
+    bool header = opt.header == csv_header::yes;
+    if (opt.header == csv_header::detect) {
+        double v;
+        for (std::string_view f : first_fields) {
+            if (!to_double(f, v)) header = true;
+        }
+    }
+    std::size_t body = header ? pos : first_pos;
+
+    // selection of columns: target[col] = -1 for x, k >= 0 for y column k
+    t.y_cols = opt.y_cols;
+    if (t.y_cols.empty()) {
+        for (int c = 0; c < n_cols; ++c) {
+            if (c != opt.x_col) t.y_cols.push_back(c);
+        }
+    }
+    int n_target = std::max(opt.x_col + 1, 0);
+    for (int c : t.y_cols) {
+        if (c < 0) throw std::runtime_error("parse_csv: invalid y column.");
+        n_target = std::max(n_target, c + 1);
+    }
+    std::vector<int> target(n_target, -2);
+    if (opt.x_col >= 0) target[opt.x_col] = -1;
+    for (std::size_t k = 0; k < t.y_cols.size(); ++k) {
+        target[t.y_cols[k]] = k;
+    }
+
+    for (int c = 0; c < std::max(n_cols, n_target); ++c) {
+        t.names.push_back(header && c < n_cols ? std::string(first_fields[c])
+                                               : "col " + std::to_string(c));
+    }
+
+    // split the body into chunks at line ends
+    Thread_pool& pool = Thread_pool::global();
+    std::size_t n_body = text.size() - body;
+    std::size_t n_chunks = std::max<std::size_t>(
+        1, std::min<std::size_t>(4 * pool.size(), n_body / min_chunk_size));
+    std::vector<std::size_t> chunk_begin(n_chunks + 1, text.size());
+    chunk_begin[0] = body;
+    for (std::size_t k = 1; k < n_chunks; ++k) {
+        std::size_t p = std::max(body + k * (n_body / n_chunks), chunk_begin[k - 1]);
+        const void* nl = std::memchr(text.data() + p, '\n', text.size() - p);
+        chunk_begin[k] = nl ? static_cast<const char*>(nl) - text.data() + 1 : text.size();
+    }
+
+    // count the rows of each chunk to know where its rows go to
+    std::vector<std::size_t> chunk_row(n_chunks + 1, 0);
+    pool.parallel_for(n_chunks, 1, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (std::size_t k = begin; k < end; ++k) {
+            std::size_t n = 0;
+            std::size_t p = chunk_begin[k];
+            while (p < chunk_begin[k + 1]) {
+                if (is_data_line(next_line(text, p))) ++n;
+            }
+            chunk_row[k + 1] = n;
+        }
+    });
+    for (std::size_t k = 0; k < n_chunks; ++k) {
+        chunk_row[k + 1] += chunk_row[k];
+    }
+    std::size_t n_rows = chunk_row[n_chunks];
+
+    // parse the chunks directly into the columns
+    t.x.assign(n_rows, NAN);
+    t.y.assign(t.y_cols.size(), std::vector<double>(n_rows, NAN));
+    pool.parallel_for(n_chunks, 1, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (std::size_t k = begin; k < end; ++k) {
+            std::size_t row = chunk_row[k];
+            std::size_t p = chunk_begin[k];
+            while (p < chunk_begin[k + 1]) {
+                std::string_view line = next_line(text, p);
+                if (!is_data_line(line)) continue;
+
+                if (opt.x_col < 0) t.x[row] = row;
+                for_each_field(line, delim, [&](int col, std::string_view f) {
+                    if (col >= n_target || target[col] == -2) return;
+                    double v;
+                    to_double(f, v); // nan if no number
+                    if (target[col] == -1) {
+                        t.x[row] = v;
+                    }
+                    else {
+                        t.y[target[col]][row] = v;
+                    }
+                });
+                ++row;
+            }
+        }
+    });
+
+    return t;
+}
+
+std::vector<int> import_csv(Coordsys_model& cm, const QString& file_name,
+                            const csv_options& opt, const ln2d_mark& m)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("import_csv: can't open " + file_name.toStdString());
+    }
+
+    // memory map the file (read it, if it can't be mapped)
+    csv_table t;
+    QByteArray data;
+    if (file.size() > 0) {
+        const uchar* p = file.map(0, file.size());
+        if (p != nullptr) {
+            t = parse_csv(std::string_view(reinterpret_cast<const char*>(p), file.size()),
+                          opt);
+            file.unmap(const_cast<uchar*>(p));
+        }
+        else {
+            data = file.readAll();
+            t = parse_csv(std::string_view(data.constData(), data.size()), opt);
+        }
+    }
+
+    // the model takes over the parsed columns, x is shared by all lines
+    auto x = std::make_shared<const std::vector<double>>(std::move(t.x));
+    std::vector<int> ids;
+    for (std::vector<double>& y : t.y) {
+        ids.push_back(cm.add_l(x, std::make_shared<const std::vector<double>>(std::move(y)), m));
+    }
+    return ids;
+}
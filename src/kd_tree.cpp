@@ -0,0 +1,114 @@
+#include "kd_tree.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm> // std::nth_element
+#include <cmath>     // std::isfinite, std::sqrt
+#include <utility>   // std::pair
+
+void Kd_tree::build(std::vector<kd_item> new_items)
+{
+    items = std::move(new_items);
+    std::erase_if(items, [](const kd_item& it) {
+        return !std::isfinite(it.x) || !std::isfinite(it.y);
+    });
+
+    // split level by level until there are enough subtrees to keep all threads
+    // busy, then build the subtrees in parallel
+    Thread_pool& pool = Thread_pool::global();
+    std::vector<std::pair<std::size_t, std::size_t>> ranges{{0, items.size()}};
+    std::vector<std::pair<std::size_t, std::size_t>> next;
+    int depth = 0;
+    while (ranges.size() < 4 * pool.size() && items.size() / ranges.size() > 4096) {
+        pool.parallel_for(ranges.size(), 1, [&](std::size_t begin, std::size_t end, unsigned) {
+            for (std::size_t k = begin; k < end; ++k) {
+                split(ranges[k].first, ranges[k].second, depth);
+            }
+        });
+        next.clear();
+        for (auto [b, e] : ranges) {
+            std::size_t m = b + (e - b) / 2;
+            next.emplace_back(b, m);
+            next.emplace_back(m + 1, e);
+        }
+        ranges.swap(next);
+        ++depth;
+    }
+
+    pool.parallel_for(ranges.size(), 1, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (std::size_t k = begin; k < end; ++k) {
+            build_range(ranges[k].first, ranges[k].second, depth);
+        }
+    });
+}
+
+void Kd_tree::split(std::size_t b, std::size_t e, int depth)
+{
+    if (e - b <= leaf_size) return;
+
+    auto m = items.begin() + b + (e - b) / 2;
+    if (depth % 2 == 0) {
+        std::nth_element(items.begin() + b, m, items.begin() + e,
+                         [](const kd_item& l, const kd_item& r) { return l.x < r.x; });
+    }
+    else {
+        std::nth_element(items.begin() + b, m, items.begin() + e,
+                         [](const kd_item& l, const kd_item& r) { return l.y < r.y; });
+    }
+}
+
+void Kd_tree::build_range(std::size_t b, std::size_t e, int depth)
+{
+    if (e - b <= leaf_size) return;
+
+    split(b, e, depth);
+    std::size_t m = b + (e - b) / 2;
+    build_range(b, m, depth + 1);
+    build_range(m + 1, e, depth + 1);
+}
+
+bool Kd_tree::nearest(double qx, double qy, double wx, double wy, double r, kd_item& found,
+                      double& d) const
+{
+    query q{qx, qy, wx, wy, r * r, items.size()};
+    nearest_range(0, items.size(), 0, q);
+    if (q.best == items.size()) return false;
+
+    found = items[q.best];
+    d = std::sqrt(q.best_d2);
+    return true;
+}
+
+void Kd_tree::nearest_range(std::size_t b, std::size_t e, int depth, query& q) const
+{
+    auto check = [&](std::size_t i) {
+        double dx = q.wx * (items[i].x - q.qx);
+        double dy = q.wy * (items[i].y - q.qy);
+        double d2 = dx * dx + dy * dy;
+        if (d2 <= q.best_d2) {
+            q.best_d2 = d2;
+            q.best = i;
+        }
+    };
+
+    if (e - b <= leaf_size) {
+        for (std::size_t i = b; i < e; ++i) {
+            check(i);
+        }
+        return;
+    }
+
+    std::size_t m = b + (e - b) / 2;
+    check(m);
+
+    // signed distance to the splitting line: search the side of the query point
+    // first, the other side only if it might contain a nearer item
+    double ds = depth % 2 == 0 ? q.wx * (q.qx - items[m].x) : q.wy * (q.qy - items[m].y);
+    if (ds < 0.0) {
+        nearest_range(b, m, depth + 1, q);
+        if (ds * ds <= q.best_d2) nearest_range(m + 1, e, depth + 1, q);
+    }
+    else {
+        nearest_range(m + 1, e, depth + 1, q);
+        if (ds * ds <= q.best_d2) nearest_range(b, m, depth + 1, q);
+    }
+}
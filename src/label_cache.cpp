@@ -0,0 +1,65 @@
+#include "label_cache.hpp"
+#include "style_table.hpp" // hash_combine
+
+#include <QFontMetrics>
+#include <QString>
+#include <QTransform>
+
+#include <bit> // std::bit_cast
+
+Label_cache::Label_cache(std::size_t capacity) : capacity(capacity) {}
+
+std::size_t Label_cache::key_hash::operator()(const key& k) const
+{
+    std::size_t h = std::hash<std::uint64_t>{}(k.v);
+    hash_combine(h, std::hash<char>{}(k.format));
+    hash_combine(h, std::hash<int>{}(k.precision));
+    hash_combine(h, std::hash<int>{}(k.font));
+    return h;
+}
+
+int Label_cache::font_idx(const QFont& font)
+{
+    for (std::size_t i = 0; i < fonts.size(); ++i) {
+        if (fonts[i] == font) return i;
+    }
+    fonts.push_back(font);
+    return fonts.size() - 1;
+}
+
+label_text Label_cache::number(double v, const QFont& font, char format, int precision)
+{
+    std::lock_guard lk(mtx);
+
+    key k{std::bit_cast<std::uint64_t>(v), format, precision, font_idx(font)};
+    auto it = labels.find(k);
+    if (it != labels.end()) {
+        lru.splice(lru.begin(), lru, it->second.lru_pos);
+        return it->second.label;
+    }
+
+    // new label: shape and measure it once
+    QString s = QString::number(v, format, precision);
+    QFontMetrics fm(font);
+    label_text l;
+    l.text = QStaticText(s);
+    l.text.setTextFormat(Qt::PlainText);
+    l.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    l.text.prepare(QTransform(), font);
+    l.advance = fm.horizontalAdvance(s);
+    l.ascent = fm.ascent();
+
+    lru.push_front(k);
+    labels.emplace(k, entry{l, lru.begin()});
+    while (labels.size() > capacity) {
+        labels.erase(lru.back());
+        lru.pop_back();
+    }
+    return l;
+}
+
+std::size_t Label_cache::size() const
+{
+    std::lock_guard lk(mtx);
+    return labels.size();
+}
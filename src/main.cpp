@@ -1,3 +1,5 @@
+#include "model_generator.hpp"
+#include "model_sequence.hpp"
 #include "w_cs_view.hpp"
 
 #include "hd/hd_functions.hpp"
@@ -5,6 +7,10 @@
 #include <QApplication>
 #include <exception>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 Coordsys make_cs()
@@ -215,6 +221,98 @@ std::vector<Coordsys_model> make_vector_of_models()
     return vm;
 }
 
+// same wave as make_vector_of_models, but the x values and the mark are stored
+// once and the frames only keep their compressed y values
+std::shared_ptr<Model_sequence> make_model_sequence()
+{
+
+    ln2d_mark lm;
+    lm.pen = QPen(Qt::red, 2, Qt::SolidLine);
+    lm.pm.symbol = Symbol::circle;
+    lm.pm.pen = QPen(Qt::green, 1, Qt::SolidLine);
+
+    double tmin = 0.0;
+    double tmax = 2.0;
+    double dt = 0.02;
+    double t_eps = 0.01 * dt;
+
+    double T = 1.0;
+    double lambda = 2.0;
+    //
+    double omega = 2. * M_PI / T;
+    double k = 2. * M_PI / lambda;
+
+    double xmin = -2.0;
+    double xmax = 2.0;
+    double dx = 0.05;
+    double x_eps = 0.01 * dx;
+
+    std::vector<double> x;
+    for (double xi = xmin; xi <= xmax + x_eps; xi += dx)
+    {
+        x.push_back(xi);
+    }
+
+    // y values quantized to 1e-6 (far below the resolution of the screen)
+    auto seq = std::make_shared<Model_sequence>(x, 1, 1.0e-6);
+    seq->set_mark(0, lm);
+
+    std::vector<double> y(x.size());
+    for (double t = tmin; t <= tmax + t_eps; t += dt)
+    {
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            y[i] = std::sin(omega * t - k * x[i]);
+        }
+        seq->add_frame(y, fmt::format("t={:.3f}", t));
+    }
+
+    return seq;
+}
+
+// same wave as make_vector_of_models, but each frame is built when it is shown
+// (or prefetched as neighbour of the frame shown)
+std::shared_ptr<Model_generator> make_model_generator()
+{
+
+    double dt = 0.02;
+    std::size_t n_frames = 101;
+
+    auto gen = [dt](std::size_t i)
+    {
+        ln2d_mark lm;
+        lm.pen = QPen(Qt::red, 2, Qt::SolidLine);
+        lm.pm.symbol = Symbol::circle;
+        lm.pm.pen = QPen(Qt::green, 1, Qt::SolidLine);
+
+        double t = i * dt;
+
+        double T = 1.0;
+        double lambda = 2.0;
+        //
+        double omega = 2. * M_PI / T;
+        double k = 2. * M_PI / lambda;
+
+        double xmin = -2.0;
+        double xmax = 2.0;
+        double dx = 0.05;
+        double x_eps = 0.01 * dx;
+
+        ln2d l;
+        for (double x = xmin; x <= xmax + x_eps; x += dx)
+        {
+            l.push_back(pt2d(x, std::sin(omega * t - k * x)));
+        }
+
+        Coordsys_model cm;
+        cm.add_l(std::move(l), lm);
+        cm.set_label(fmt::format("t={:.3f}", t));
+        return cm;
+    };
+
+    return std::make_shared<Model_generator>(n_frames, gen);
+}
+
 int main(int argc, char* argv[])
 {
 
@@ -226,9 +324,35 @@ int main(int argc, char* argv[])
 
         // fmt::print("Size of cs = {}\n", sizeof(cs));
 
-        // single model case
+        // command line options: --sequence or --generator show a multi model
+        // case with frames built on demand, --async renders on a worker thread
+        bool sequence = false;
+        bool generator = false;
+        bool async = false;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--sequence")
+                sequence = true;
+            else if (arg == "--generator")
+                generator = true;
+            else if (arg == "--async")
+                async = true;
+            else
+                throw std::runtime_error("unknown option " + std::string(arg) +
+                                         " (use --sequence, --generator or --async)\n");
+        }
+
+        // single model case (default) or frames built on demand
         Coordsys_model cm = make_model();
-        w_Cs_view window(&cs, &cm);
+        std::unique_ptr<w_Cs_view> w;
+        if (sequence)
+            w = std::make_unique<w_Cs_view>(&cs, make_model_sequence());
+        else if (generator)
+            w = std::make_unique<w_Cs_view>(&cs, make_model_generator());
+        else
+            w = std::make_unique<w_Cs_view>(&cs, &cm);
+        w_Cs_view& window = *w;
 
         // multi model case
         // std::vector<Coordsys_model> vmodels;
@@ -240,6 +364,10 @@ int main(int argc, char* argv[])
         // }
         // w_Cs_view window(&cs, vm);
 
+        // the models are not modified after this point: they may be rendered on
+        // a worker thread
+        if (async) window.coordsys_widget()->set_async_render(true);
+
         // window.resize(600, 600);
         window.setWindowTitle("Coordsys");
         window.show();
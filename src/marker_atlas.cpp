@@ -0,0 +1,238 @@
+#include "coordsys_model.hpp"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <algorithm> // std::max
+#include <cmath>     // std::ceil, std::lround
+#include <cstdint>
+#include <functional> // std::hash
+
+void draw_symbol(QPainter* qp, Symbol symbol, int nx, int ny, int nsize)
+{
+    switch (symbol)
+    {
+    case Symbol::plus:
+    {
+        qp->drawLine(nx - nsize, ny, nx + nsize, ny);
+        qp->drawLine(nx, ny - nsize, nx, ny + nsize);
+        break;
+    }
+    case Symbol::cross:
+    {
+        qp->drawLine(nx - nsize, ny - nsize, nx + nsize, ny + nsize);
+        qp->drawLine(nx - nsize, ny + nsize, nx + nsize, ny - nsize);
+        break;
+    }
+    case Symbol::circle:
+    {
+        qp->drawEllipse(QPoint(nx, ny), nsize, nsize);
+        break;
+    }
+    case Symbol::square:
+    {
+        qp->drawLine(nx - nsize, ny - nsize, nx + nsize, ny - nsize);
+        qp->drawLine(nx + nsize, ny - nsize, nx + nsize, ny + nsize);
+        qp->drawLine(nx + nsize, ny + nsize, nx - nsize, ny + nsize);
+        qp->drawLine(nx - nsize, ny + nsize, nx - nsize, ny - nsize);
+        break;
+    }
+    }
+}
+
+// half size of sprite in device independent pixels (incl. pen width and margin)
+static int sprite_half_size(const pt2d_mark& m)
+{
+    return m.nsize + std::ceil(m.pen.widthF()) + 1;
+}
+
+std::size_t Marker_atlas::sprite_key_hash::operator()(const sprite_key& k) const
+{
+    std::size_t h = std::hash<int>{}(k.symbol);
+    hash_combine(h, std::hash<int>{}(k.nsize));
+    hash_combine(h, std::hash<QRgb>{}(k.color));
+    hash_combine(h, std::hash<qreal>{}(k.width));
+    hash_combine(h, std::hash<int>{}(k.style));
+    hash_combine(h, std::hash<int>{}(k.cap));
+    hash_combine(h, std::hash<int>{}(k.join));
+    return h;
+}
+
+int Marker_atlas::sprite(const pt2d_mark& m)
+{
+    if (2 * sprite_half_size(m) > max_sprite_size) return -1;
+
+    sprite_key key{m.symbol,        m.nsize,          m.pen.color().rgba(),
+                   m.pen.widthF(),  m.pen.style(),    m.pen.capStyle(),
+                   m.pen.joinStyle()};
+
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+
+    int id = marks.size();
+    ids.emplace(key, id);
+    marks.push_back(m);
+    dirty = true;
+    return id;
+}
+
+void Marker_atlas::clear()
+{
+    ids.clear();
+    marks.clear();
+    rects.clear();
+    atlas = QImage();
+    atlas_pm = QPixmap();
+    dirty = true;
+}
+
+void Marker_atlas::draw(QPainter* qp, const std::vector<marker_inst>& inst)
+{
+    if (inst.empty()) return;
+
+    qreal dpr = qp->device()->devicePixelRatioF();
+    bool aa = qp->testRenderHint(QPainter::Antialiasing);
+    if (dirty || dpr != atlas_dpr || aa != atlas_aa) render(dpr, aa);
+
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app == nullptr || QThread::currentThread() != app->thread())
+    {
+        // QPixmap is not available outside the gui thread (Render_thread)
+        if (blend_into_image(qp, inst)) return;
+
+        // other devices or painter states: copy through the painter; the atlas
+        // has the device pixel ratio of the target, so the sprites are blended
+        // 1:1 w/o scaling
+        for (const marker_inst& m : inst)
+        {
+            const QRect& r = rects[m.sprite];
+            qp->drawImage(QPointF(m.nx - 0.5 * r.width() / dpr, m.ny - 0.5 * r.height() / dpr),
+                          atlas, QRectF(r));
+        }
+        return;
+    }
+
+    if (pm_dirty)
+    {
+        atlas_pm = QPixmap::fromImage(atlas);
+        pm_dirty = false;
+    }
+
+    // all sprites with one call (fragments are centered on their position,
+    // scaled from device pixels of the atlas to logical pixels)
+    frags.clear();
+    frags.reserve(inst.size());
+    for (const marker_inst& m : inst)
+    {
+        frags.push_back(QPainter::PixmapFragment::create(
+            QPointF(m.nx, m.ny), QRectF(rects[m.sprite]), 1.0 / dpr, 1.0 / dpr));
+    }
+    qp->drawPixmapFragments(frags.data(), int(frags.size()), atlas_pm);
+}
+
+// premultiplied x * a / 255 for all four channels at once
+static QRgb byte_mul(QRgb x, std::uint32_t a)
+{
+    std::uint32_t t = (x & 0xff00ff) * a;
+    t = ((t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = (x + ((x >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+    return x | t;
+}
+
+bool Marker_atlas::blend_into_image(QPainter* qp, const std::vector<marker_inst>& inst) const
+{
+    // only plain source-over into premultiplied images w/o rotation or shear
+    // (anything else is left to the painter)
+    QPaintDevice* dev = qp->device();
+    if (dev->devType() != QInternal::Image) return false;
+    QImage* img = static_cast<QImage*>(dev);
+    const QTransform& t = qp->deviceTransform();
+    if (img->format() != QImage::Format_ARGB32_Premultiplied ||
+        t.type() > QTransform::TxScale || qp->opacity() != 1.0 ||
+        qp->compositionMode() != QPainter::CompositionMode_SourceOver)
+        return false;
+
+    // clip in device pixels (only rectangular clips are handled here)
+    QRect clip = img->rect();
+    if (qp->hasClipping())
+    {
+        if (qp->clipRegion().rectCount() > 1) return false;
+        clip = clip.intersected(t.mapRect(qp->clipBoundingRect()).toAlignedRect());
+    }
+
+    for (const marker_inst& m : inst)
+    {
+        const QRect& r = rects[m.sprite];
+        QPointF c = t.map(QPointF(m.nx, m.ny));
+        int x0 = std::lround(c.x()) - r.width() / 2;
+        int y0 = std::lround(c.y()) - r.height() / 2;
+        QRect d = QRect(x0, y0, r.width(), r.height()).intersected(clip);
+        if (d.isEmpty()) continue;
+
+        for (int y = d.top(); y <= d.bottom(); ++y)
+        {
+            const QRgb* src = reinterpret_cast<const QRgb*>(atlas.constScanLine(r.y() + y - y0)) +
+                              r.x() + d.left() - x0;
+            QRgb* dst = reinterpret_cast<QRgb*>(img->scanLine(y)) + d.left();
+            for (int x = 0; x < d.width(); ++x)
+            {
+                std::uint32_t ia = 255 - qAlpha(src[x]);
+                if (ia == 0)
+                    dst[x] = src[x];
+                else if (ia < 255)
+                    dst[x] = src[x] + byte_mul(dst[x], ia);
+            }
+        }
+    }
+    return true;
+}
+
+void Marker_atlas::render(qreal dpr, bool aa)
+{
+    // simple shelf packing of the sprites in rows of atlas_width
+    rects.resize(marks.size());
+    int x = 0;
+    int y = 0;
+    int row_height = 0;
+    for (std::size_t i = 0; i < marks.size(); ++i)
+    {
+        // even size in device pixels to have the center on a pixel corner
+        int size = std::ceil(2 * sprite_half_size(marks[i]) * dpr);
+        size += size % 2;
+        if (x + size > atlas_width)
+        {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+        rects[i] = QRect(x, y, size, size);
+        x += size;
+        row_height = std::max(row_height, size);
+    }
+
+    atlas = QImage(atlas_width, std::max(y + row_height, 1),
+                   QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+
+    QPainter p(&atlas);
+    p.setRenderHint(QPainter::Antialiasing, aa);
+    for (std::size_t i = 0; i < marks.size(); ++i)
+    {
+        p.save();
+        p.translate(rects[i].x() + rects[i].width() / 2,
+                    rects[i].y() + rects[i].height() / 2);
+        p.scale(dpr, dpr);
+        p.setPen(marks[i].pen);
+        draw_symbol(&p, marks[i].symbol, 0, 0, marks[i].nsize);
+        p.restore();
+    }
+
+    p.end();
+    atlas.setDevicePixelRatio(dpr);
+
+    dirty = false;
+    pm_dirty = true;
+    atlas_dpr = dpr;
+    atlas_aa = aa;
+}
@@ -0,0 +1,176 @@
+#include "model_generator.hpp"
+
+#include <algorithm> // std::max
+#include <stdexcept>
+#include <utility>   // std::move
+
+Model_generator::Model_generator(std::size_t n_frames, gen_fn gen, std::size_t capacity,
+                                 std::size_t prefetch, unsigned n_workers) :
+    n_frames(n_frames), gen(std::move(gen)),
+    capacity(std::max<std::size_t>(capacity, 2 * prefetch + 1 + n_workers)),
+    prefetch(prefetch)
+{
+    if (n_frames == 0) throw std::runtime_error("Model_generator requires n_frames > 0.");
+    if (!this->gen) throw std::runtime_error("Model_generator requires a generator.");
+
+    for (unsigned i = 0; i < n_workers; ++i) {
+        workers.emplace_back([this](std::stop_token st) { run(st); });
+    }
+}
+
+Model_generator::~Model_generator()
+{
+    for (std::jthread& w : workers) {
+        w.request_stop();
+    }
+    // the jthreads are joined on destruction (after finishing their frame)
+}
+
+std::size_t Model_generator::n_cached() const
+{
+    std::lock_guard lk(mtx);
+    return cache.size();
+}
+
+std::shared_ptr<Coordsys_model> Model_generator::frame(std::size_t idx)
+{
+    if (idx >= n_frames) throw std::runtime_error("Model_generator: invalid frame index.");
+
+    std::unique_lock lk(mtx);
+    request_neighbours(idx);
+
+    while (true) {
+        auto it = cache.find(idx);
+        if (it != cache.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru_pos);
+            return it->second.cm;
+        }
+        if (!building.contains(idx)) break;
+
+        // a worker is already on it
+        cv_done.wait(lk);
+    }
+
+    // build it here instead of waiting for a worker
+    building.insert(idx);
+    lk.unlock();
+
+    std::shared_ptr<Coordsys_model> cm;
+    try {
+        cm = std::make_shared<Coordsys_model>(gen(idx));
+    }
+    catch (...) {
+        lk.lock();
+        building.erase(idx);
+        cv_done.notify_all();
+        throw;
+    }
+
+    lk.lock();
+    building.erase(idx);
+    failed.erase(idx);
+    insert(idx, cm);
+    cv_done.notify_all();
+    return cm;
+}
+
+std::shared_ptr<Coordsys_model> Model_generator::try_frame(std::size_t idx)
+{
+    if (idx >= n_frames) throw std::runtime_error("Model_generator: invalid frame index.");
+
+    std::unique_lock lk(mtx);
+    auto it = cache.find(idx);
+    if (it != cache.end()) {
+        if (requested == idx) requested = SIZE_MAX;
+        request_neighbours(idx);
+        lru.splice(lru.begin(), lru, it->second.lru_pos);
+        return it->second.cm;
+    }
+
+    if (failed.contains(idx)) {
+        // the worker failed: build it here to report the error
+        failed.erase(idx);
+        lk.unlock();
+        return frame(idx);
+    }
+
+    // the frame itself first, then its neighbours
+    requested = idx;
+    request_neighbours(idx);
+    if (!building.contains(idx)) wanted.push_front(idx);
+    cv.notify_all();
+    return nullptr;
+}
+
+void Model_generator::on_frame_ready(std::function<void(std::size_t)> fn)
+{
+    std::lock_guard lk(mtx);
+    ready_fn = std::move(fn);
+}
+
+void Model_generator::insert(std::size_t idx, std::shared_ptr<Coordsys_model> cm)
+{
+    lru.push_front(idx);
+    cache[idx] = entry{std::move(cm), lru.begin()};
+
+    while (cache.size() > capacity) {
+        cache.erase(lru.back());
+        lru.pop_back();
+    }
+}
+
+void Model_generator::request_neighbours(std::size_t idx)
+{
+    // nearest neighbours first, the next frame before the previous one
+    wanted.clear();
+    for (std::size_t d = 1; d <= prefetch; ++d) {
+        if (idx + d < n_frames) wanted.push_back(idx + d);
+        if (idx >= d) wanted.push_back(idx - d);
+    }
+
+    // neighbours already cached count as used now (they are not dropped before
+    // frames further away)
+    for (auto it = wanted.rbegin(); it != wanted.rend(); ++it) {
+        auto c = cache.find(*it);
+        if (c != cache.end()) lru.splice(lru.begin(), lru, c->second.lru_pos);
+    }
+    cv.notify_all();
+}
+
+void Model_generator::run(std::stop_token st)
+{
+    std::unique_lock lk(mtx);
+    while (true) {
+        if (!cv.wait(lk, st, [this] { return !wanted.empty(); })) return;
+
+        std::size_t idx = wanted.front();
+        wanted.pop_front();
+        if (cache.contains(idx) || building.contains(idx)) continue;
+
+        building.insert(idx);
+        lk.unlock();
+
+        std::shared_ptr<Coordsys_model> cm;
+        try {
+            cm = std::make_shared<Coordsys_model>(gen(idx));
+        }
+        catch (...) {
+            // dropped: frame() or try_frame() builds it again and reports the error
+        }
+
+        lk.lock();
+        building.erase(idx);
+        // the current frame and its neighbours are the most recently used ones,
+        // capacity also covers frames of the workers that got outdated meanwhile
+        if (cm) {
+            insert(idx, std::move(cm));
+        }
+        else {
+            failed.insert(idx);
+        }
+        cv_done.notify_all();
+
+        // called with mtx locked: fn must not be removed while it is running
+        if (idx == requested && ready_fn) ready_fn(idx);
+    }
+}
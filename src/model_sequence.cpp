@@ -0,0 +1,168 @@
+#include "model_sequence.hpp"
+
+#include <bit>   // std::bit_cast
+#include <cmath> // std::abs, std::isnan, std::round
+#include <stdexcept>
+
+// code of nan for quantized values (never reached by a quantized number)
+static constexpr std::uint64_t nan_code = std::uint64_t(1) << 63;
+
+static void put_varint(std::vector<std::uint8_t>& data, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        data.push_back(static_cast<std::uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    data.push_back(static_cast<std::uint8_t>(v));
+}
+
+static std::uint64_t get_varint(const std::uint8_t*& p)
+{
+    std::uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        std::uint8_t b = *p++;
+        v |= std::uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+Model_sequence::Model_sequence(std::vector<double> x, int n_lines, double q,
+                               std::size_t key_interval) :
+    x(std::make_shared<const std::vector<double>>(std::move(x))),
+    n_lines(n_lines), q(q), key_interval(key_interval), marks(n_lines, ln2d_mark_default)
+{
+    if (n_lines < 1) throw std::runtime_error("Model_sequence requires n_lines > 0.");
+    if (!(q >= 0.0)) throw std::runtime_error("Model_sequence requires q >= 0.");
+    if (key_interval == 0)
+        throw std::runtime_error("Model_sequence requires key_interval > 0.");
+}
+
+void Model_sequence::set_mark(int line, const ln2d_mark& m)
+{
+    if (line < 0 || line >= n_lines)
+        throw std::runtime_error("Model_sequence: invalid line index.");
+    marks[line] = m;
+}
+
+std::uint64_t Model_sequence::encode(double y) const
+{
+    if (q == 0.0) return std::bit_cast<std::uint64_t>(y);
+
+    if (std::isnan(y)) return nan_code;
+    double r = std::round(y / q);
+    if (!(std::abs(r) < 0x1p62))
+        throw std::runtime_error("Model_sequence: value out of range for quantization.");
+    return static_cast<std::uint64_t>(static_cast<std::int64_t>(r));
+}
+
+double Model_sequence::decode(std::uint64_t c) const
+{
+    if (q == 0.0) return std::bit_cast<double>(c);
+
+    if (c == nan_code) return NAN;
+    return static_cast<std::int64_t>(c) * q;
+}
+
+std::uint64_t Model_sequence::delta(std::uint64_t c, std::uint64_t ref) const
+{
+    if (q == 0.0) return c ^ ref; // similar doubles share the leading bits
+
+    // zigzag: small differences of either sign become small numbers
+    std::int64_t d = static_cast<std::int64_t>(c - ref);
+    return (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63);
+}
+
+std::uint64_t Model_sequence::undelta(std::uint64_t d, std::uint64_t ref) const
+{
+    if (q == 0.0) return d ^ ref;
+
+    return ref + ((d >> 1) ^ (~(d & 1) + 1));
+}
+
+void Model_sequence::add_frame(std::span<const double> y, const std::string& label)
+{
+    std::size_t n = x->size() * n_lines;
+    if (y.size() != n)
+        throw std::runtime_error("Model_sequence: frame requires n_lines * x.size() values.");
+
+    std::size_t idx = labels.size();
+    bool key = idx % key_interval == 0;
+
+    std::vector<std::uint64_t> codes(n);
+    for (std::size_t j = 0; j < n; ++j) {
+        codes[j] = encode(y[j]);
+    }
+
+    frame_pos.push_back(data.size());
+    for (std::size_t j = 0; j < n; ++j) {
+        // key frame: delta to the previous vertex, otherwise to the previous frame
+        std::uint64_t ref = key ? (j > 0 ? codes[j - 1] : 0) : last_codes[j];
+        put_varint(data, delta(codes[j], ref));
+    }
+
+    last_codes = std::move(codes);
+    labels.push_back(label);
+}
+
+void Model_sequence::decode_frame(std::size_t idx)
+{
+    std::size_t n = x->size() * n_lines;
+    std::size_t key_idx = idx - idx % key_interval;
+
+    // continue from the last decoded frame if it is on the way
+    std::size_t from = key_idx;
+    if (dec_idx != SIZE_MAX && dec_idx >= key_idx && dec_idx <= idx) {
+        if (dec_idx == idx) return;
+        from = dec_idx + 1;
+    }
+
+    dec_codes.resize(n);
+    for (std::size_t i = from; i <= idx; ++i) {
+        const std::uint8_t* p = data.data() + frame_pos[i];
+        bool key = i == key_idx;
+        for (std::size_t j = 0; j < n; ++j) {
+            std::uint64_t ref = key ? (j > 0 ? dec_codes[j - 1] : 0) : dec_codes[j];
+            dec_codes[j] = undelta(get_varint(p), ref);
+        }
+    }
+    dec_idx = idx;
+}
+
+std::shared_ptr<Coordsys_model> Model_sequence::frame(std::size_t idx)
+{
+    if (idx >= size()) throw std::runtime_error("Model_sequence: invalid frame index.");
+
+    decode_frame(idx);
+
+    // the model refers to the shared x values and to the y values of the frame,
+    // which live as long as the model
+    struct frame_data {
+        std::shared_ptr<const std::vector<double>> x;
+        std::vector<double> y;
+        Coordsys_model cm;
+    };
+    auto f = std::make_shared<frame_data>();
+    f->x = x;
+    f->y.resize(dec_codes.size());
+    for (std::size_t j = 0; j < dec_codes.size(); ++j) {
+        f->y[j] = decode(dec_codes[j]);
+    }
+
+    std::size_t nx = x->size();
+    std::span<const double> ys(f->y);
+    for (int l = 0; l < n_lines; ++l) {
+        f->cm.add_l_view(std::span<const double>(*x), ys.subspan(l * nx, nx), marks[l]);
+    }
+    f->cm.set_label(labels[idx]);
+
+    return std::shared_ptr<Coordsys_model>(f, &f->cm);
+}
+
+std::size_t Model_sequence::bytes() const
+{
+    std::size_t b = data.capacity() + frame_pos.capacity() * sizeof(std::size_t);
+    for (const std::string& s : labels) {
+        b += sizeof(std::string) + s.capacity();
+    }
+    return b;
+}
@@ -0,0 +1,124 @@
+#include "render_thread.hpp"
+
+#include <QPainter>
+
+#include <utility> // std::move
+
+Render_thread::Render_thread(std::function<void()> on_frame) :
+    on_frame(std::move(on_frame)), worker([this](std::stop_token st) { run(st); })
+{
+}
+
+Render_thread::~Render_thread()
+{
+    {
+        std::lock_guard lk(mtx);
+        current_stop.request_stop();
+    }
+    worker.request_stop();
+    // the jthread is joined on destruction
+}
+
+void Render_thread::request(const Coordsys& cs, Coordsys_model* cm, const frame_key& key,
+                            std::shared_ptr<const void> keep)
+{
+    {
+        std::lock_guard lk(mtx);
+        // the running frame is finished (and presented with its own key):
+        // stopping it on each request would starve the widget of frames if
+        // requests come faster than frames are rendered (e.g. during pan)
+        pending.emplace(job{cs, cm, key, std::move(keep)});
+        last_key = key;
+    }
+    cv.notify_all();
+}
+
+bool Render_thread::take_frame(QImage& frame, frame_key& key,
+                               Coordsys_model::stream_state& streams)
+{
+    std::lock_guard lk(mtx);
+    if (!has_frame) return false;
+
+    frame = std::move(frame_done);
+    key = frame_done_key;
+    streams = frame_done_streams;
+    frame_done = QImage();
+    has_frame = false;
+    return true;
+}
+
+std::optional<frame_key> Render_thread::requested() const
+{
+    std::lock_guard lk(mtx);
+    return last_key;
+}
+
+void Render_thread::wait_idle()
+{
+    std::unique_lock lk(mtx);
+    cv_idle.wait(lk, [this] { return !pending && !rendering; });
+}
+
+void Render_thread::cancel()
+{
+    {
+        std::lock_guard lk(mtx);
+        pending.reset();
+        last_key.reset();
+        current_stop.request_stop();
+    }
+    wait_idle();
+}
+
+void Render_thread::run(std::stop_token st)
+{
+    while (true) {
+        std::optional<job> j;
+        std::stop_token stop;
+        {
+            std::unique_lock lk(mtx);
+            if (!cv.wait(lk, st, [this] { return pending.has_value(); })) return;
+
+            j = std::move(pending);
+            pending.reset();
+            current_stop = std::stop_source();
+            stop = current_stop.get_token();
+            rendering = true;
+        }
+
+        Coordsys_model::stream_state streams;
+        QImage img = render(*j, stop, streams);
+
+        bool done = false;
+        {
+            std::lock_guard lk(mtx);
+            rendering = false;
+            if (!stop.stop_requested()) {
+                frame_done = std::move(img);
+                frame_done_key = j->key;
+                frame_done_streams = std::move(streams);
+                has_frame = true;
+                done = true;
+            }
+        }
+        cv_idle.notify_all();
+
+        if (done && on_frame) on_frame();
+    }
+}
+
+QImage Render_thread::render(job& j, std::stop_token stop,
+                             Coordsys_model::stream_state& streams)
+{
+    // render at device resolution to stay sharp on high dpi screens
+    QImage img(j.key.size * j.key.dpr, QImage::Format_ARGB32_Premultiplied);
+    img.setDevicePixelRatio(j.key.dpr);
+    img.fill(Qt::transparent);
+
+    QPainter qp(&img);
+    qp.setRenderHint(QPainter::Antialiasing);
+    j.cs.draw(&qp);
+    if (j.cm != nullptr && !stop.stop_requested()) j.cm->draw(&qp, &j.cs, stop, &streams);
+
+    return img;
+}
@@ -0,0 +1,109 @@
+#include "ring_series.hpp"
+
+#include <algorithm> // std::max, std::min
+#include <stdexcept>
+
+Ring_series::Ring_series(std::size_t capacity) :
+    cap(capacity), xs(capacity), ys(capacity)
+{
+    if (capacity == 0) throw std::runtime_error("Ring_series requires capacity > 0.");
+}
+
+Ring_series::Ring_series(const Ring_series& other)
+{
+    std::lock_guard lk(other.mtx);
+    cap = other.cap;
+    xs = other.xs;
+    ys = other.ys;
+    n_total = other.n_total;
+    n_first = other.n_first;
+}
+
+Ring_series& Ring_series::operator=(const Ring_series& other)
+{
+    if (this == &other) return *this;
+
+    std::scoped_lock lk(mtx, other.mtx);
+    cap = other.cap;
+    xs = other.xs;
+    ys = other.ys;
+    n_total = other.n_total;
+    n_first = other.n_first;
+    return *this;
+}
+
+void Ring_series::push(double x, double y)
+{
+    std::size_t i = n_total % cap;
+    xs[i] = x;
+    ys[i] = y;
+    ++n_total;
+}
+
+void Ring_series::append(double x, double y)
+{
+    std::lock_guard lk(mtx);
+    push(x, y);
+}
+
+void Ring_series::append(std::span<const double> x, std::span<const double> y)
+{
+    if (x.size() != y.size())
+        throw std::runtime_error("Ring_series: x and y values must have the same size.");
+
+    std::lock_guard lk(mtx);
+    for (std::size_t j = 0; j < x.size(); ++j) {
+        push(x[j], y[j]);
+    }
+}
+
+void Ring_series::clear()
+{
+    std::lock_guard lk(mtx);
+    n_first = n_total;
+}
+
+std::size_t Ring_series::size() const
+{
+    std::lock_guard lk(mtx);
+    return std::min<std::uint64_t>(n_total - n_first, cap);
+}
+
+std::uint64_t Ring_series::total() const
+{
+    std::lock_guard lk(mtx);
+    return n_total;
+}
+
+std::uint64_t Ring_series::first() const
+{
+    std::lock_guard lk(mtx);
+    return n_first;
+}
+
+bool Ring_series::last_x(double& x) const
+{
+    std::lock_guard lk(mtx);
+    if (n_total == n_first) return false;
+    x = xs[(n_total - 1) % cap];
+    return true;
+}
+
+std::uint64_t Ring_series::copy_since(std::uint64_t from, std::vector<double>& x,
+                                      std::vector<double>& y) const
+{
+    std::lock_guard lk(mtx);
+
+    std::uint64_t oldest = std::max(n_total > cap ? n_total - cap : 0, n_first);
+    from = std::max(from, oldest);
+    std::size_t n = from < n_total ? n_total - from : 0;
+
+    x.resize(n);
+    y.resize(n);
+    for (std::size_t j = 0; j < n; ++j) {
+        std::size_t i = (from + j) % cap;
+        x[j] = xs[i];
+        y[j] = ys[i];
+    }
+    return from;
+}
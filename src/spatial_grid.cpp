@@ -0,0 +1,293 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm> // std::min, std::max, std::sort
+#include <cmath>     // std::isfinite, std::floor
+#include <cstdint>
+#include <numeric>   // std::iota
+#include <stdexcept>
+
+static bool is_finite(const bbox2d& b)
+{
+    return std::isfinite(b.xmin) && std::isfinite(b.xmax) && std::isfinite(b.ymin) &&
+           std::isfinite(b.ymax);
+}
+
+void Spatial_grid::insert(std::size_t idx, const bbox2d& b)
+{
+    if (idx != box.size())
+        throw std::runtime_error("Spatial_grid requires insertion in index order.");
+
+    box.push_back(b);
+    stamp.push_back(0);
+
+    if (!is_finite(b)) {
+        big.push_back(idx);
+        return;
+    }
+
+    if (!has_ext || !ext.contains(b)) {
+        // grow extent with head room for further items (e.g. growing series)
+        bbox2d u = b;
+        if (has_ext) {
+            u.xmin = std::min(u.xmin, ext.xmin);
+            u.xmax = std::max(u.xmax, ext.xmax);
+            u.ymin = std::min(u.ymin, ext.ymin);
+            u.ymax = std::max(u.ymax, ext.ymax);
+        }
+        double w = 0.5 * (u.xmax - u.xmin);
+        double h = 0.5 * (u.ymax - u.ymin);
+        u.xmin -= w;
+        u.xmax += w;
+        u.ymin -= h;
+        u.ymax += h;
+        rebuild(u, std::max(nx, n_start));
+        return;
+    }
+
+    if (nx < n_max && box.size() > std::size_t(items_per_cell) * nx * ny) {
+        // refine grid
+        rebuild(ext, std::min(2 * nx, n_max));
+        return;
+    }
+
+    add_to_cells(idx);
+}
+
+void Spatial_grid::clear()
+{
+    box.clear();
+    stamp.clear();
+    big.clear();
+    cells.clear();
+    has_ext = false;
+    nx = 0;
+    ny = 0;
+    qstamp = 0;
+}
+
+void Spatial_grid::query(const bbox2d& view, std::vector<std::size_t>& result) const
+{
+    result.clear();
+
+    if (!has_ext || view.contains(ext)) {
+        // everything finite is visible: no need to go through the cells
+        result.resize(box.size());
+        std::iota(result.begin(), result.end(), 0);
+        if (!big.empty()) {
+            std::erase_if(result, [&](std::size_t i) { return !view.intersects(box[i]); });
+        }
+        return;
+    }
+
+    if (++qstamp == 0) { // wrap around: reset all marks
+        std::fill(stamp.begin(), stamp.end(), 0);
+        qstamp = 1;
+    }
+
+    if (view.intersects(ext)) {
+        int cx0 = cell_x(view.xmin);
+        int cx1 = cell_x(view.xmax);
+        int cy0 = cell_y(view.ymin);
+        int cy1 = cell_y(view.ymax);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                for (std::size_t i : cells[cy * nx + cx]) {
+                    if (stamp[i] != qstamp) {
+                        stamp[i] = qstamp;
+                        if (view.intersects(box[i])) result.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+
+    for (std::size_t i : big) {
+        if (view.intersects(box[i])) result.push_back(i);
+    }
+
+    // keep insertion order of the model (z-order of items)
+    std::sort(result.begin(), result.end());
+}
+
+void Spatial_grid::rebuild(const bbox2d& new_ext, int new_n)
+{
+    ext = new_ext;
+    has_ext = true;
+    nx = new_n;
+    ny = new_n;
+
+    cells.assign(std::size_t(nx) * ny, {});
+    big.clear();
+
+    for (std::size_t i = 0; i < box.size(); ++i) {
+        if (is_finite(box[i])) {
+            add_to_cells(i);
+        }
+        else {
+            big.push_back(i);
+        }
+    }
+}
+
+void Spatial_grid::add_to_cells(std::size_t idx)
+{
+    const bbox2d& b = box[idx];
+    int cx0 = cell_x(b.xmin);
+    int cx1 = cell_x(b.xmax);
+    int cy0 = cell_y(b.ymin);
+    int cy1 = cell_y(b.ymax);
+
+    if ((cx1 - cx0 + 1) * (cy1 - cy0 + 1) > max_item_cells) {
+        big.push_back(idx);
+        return;
+    }
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            cells[cy * nx + cx].push_back(idx);
+        }
+    }
+}
+
+// cell of v in n cells over [lo, hi] (values outside go to the border cells)
+static int cell_of(double v, double lo, double hi, int n)
+{
+    double w = hi - lo;
+    if (w <= 0.0) return 0;
+    double c = std::floor((v - lo) / w * n);
+    return std::clamp(c, 0.0, double(n - 1));
+}
+
+int Spatial_grid::cell_x(double x) const
+{
+    return cell_of(x, ext.xmin, ext.xmax, nx);
+}
+
+int Spatial_grid::cell_y(double y) const
+{
+    return cell_of(y, ext.ymin, ext.ymax, ny);
+}
+
+void Point_grid::insert(std::size_t idx, std::span<const double> x,
+                        std::span<const double> y)
+{
+    if (idx != n)
+        throw std::runtime_error("Point_grid requires insertion in index order.");
+    if (idx > UINT32_MAX) throw std::runtime_error("Point_grid: too many points.");
+    ++n;
+
+    double px = x[idx];
+    double py = y[idx];
+    if (!std::isfinite(px) || !std::isfinite(py)) {
+        big.push_back(idx);
+        return;
+    }
+
+    if (!has_ext || px < ext.xmin || ext.xmax < px || py < ext.ymin || ext.ymax < py) {
+        // grow extent with head room for further points (e.g. growing series)
+        bbox2d u{px, px, py, py};
+        if (has_ext) {
+            u.xmin = std::min(u.xmin, ext.xmin);
+            u.xmax = std::max(u.xmax, ext.xmax);
+            u.ymin = std::min(u.ymin, ext.ymin);
+            u.ymax = std::max(u.ymax, ext.ymax);
+        }
+        double w = 0.5 * (u.xmax - u.xmin);
+        double h = 0.5 * (u.ymax - u.ymin);
+        u.xmin -= w;
+        u.xmax += w;
+        u.ymin -= h;
+        u.ymax += h;
+        rebuild(x, y, u, std::max(nx, n_start));
+        return;
+    }
+
+    if (nx < n_max && n > std::size_t(items_per_cell) * nx * ny) {
+        // refine grid
+        rebuild(x, y, ext, std::min(2 * nx, n_max));
+        return;
+    }
+
+    add_to_cells(idx, px, py);
+}
+
+void Point_grid::clear()
+{
+    n = 0;
+    big.clear();
+    cells.clear();
+    has_ext = false;
+    nx = 0;
+    ny = 0;
+}
+
+void Point_grid::query(const bbox2d& view, std::span<const double> x,
+                       std::span<const double> y, std::vector<std::size_t>& result) const
+{
+    result.clear();
+
+    auto inside = [&](std::size_t i) {
+        return view.xmin <= x[i] && x[i] <= view.xmax && view.ymin <= y[i] &&
+               y[i] <= view.ymax;
+    };
+
+    if (!has_ext || view.contains(ext)) {
+        // everything finite is visible: no need to go through the cells
+        result.resize(n);
+        std::iota(result.begin(), result.end(), 0);
+        if (!big.empty()) std::erase_if(result, [&](std::size_t i) { return !inside(i); });
+        return;
+    }
+
+    if (view.intersects(ext)) {
+        int cx0 = cell_of(view.xmin, ext.xmin, ext.xmax, nx);
+        int cx1 = cell_of(view.xmax, ext.xmin, ext.xmax, nx);
+        int cy0 = cell_of(view.ymin, ext.ymin, ext.ymax, ny);
+        int cy1 = cell_of(view.ymax, ext.ymin, ext.ymax, ny);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                // inner cells are within view entirely
+                bool inner = cx0 < cx && cx < cx1 && cy0 < cy && cy < cy1;
+                for (std::uint32_t i : cells[cy * nx + cx]) {
+                    if (inner || inside(i)) result.push_back(i);
+                }
+            }
+        }
+    }
+
+    // non-finite points are never within view (nan compares false)
+    for (std::uint32_t i : big) {
+        if (inside(i)) result.push_back(i);
+    }
+
+    // keep insertion order of the model (z-order of points)
+    std::sort(result.begin(), result.end());
+}
+
+void Point_grid::rebuild(std::span<const double> x, std::span<const double> y,
+                         const bbox2d& new_ext, int new_n)
+{
+    ext = new_ext;
+    has_ext = true;
+    nx = new_n;
+    ny = new_n;
+
+    cells.assign(std::size_t(nx) * ny, {});
+    big.clear();
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (std::isfinite(x[i]) && std::isfinite(y[i])) {
+            add_to_cells(i, x[i], y[i]);
+        }
+        else {
+            big.push_back(i);
+        }
+    }
+}
+
+void Point_grid::add_to_cells(std::size_t idx, double x, double y)
+{
+    int cx = cell_of(x, ext.xmin, ext.xmax, nx);
+    int cy = cell_of(y, ext.ymin, ext.ymax, ny);
+    cells[cy * nx + cx].push_back(std::uint32_t(idx));
+}
@@ -0,0 +1,157 @@
+#include "thread_pool.hpp"
+
+#include <algorithm> // std::max, std::min
+
+// set while a thread works for a pool (nested calls run sequentially in the
+// slot of the thread)
+static thread_local bool in_pool_work{false};
+static thread_local unsigned pool_slot{0};
+
+Thread_pool::Thread_pool(unsigned n_threads)
+{
+    n_threads = std::max(n_threads, 1u);
+
+    for (unsigned slot = 0; slot < n_threads; ++slot) {
+        queues.push_back(std::make_unique<chunk_queue>());
+    }
+    for (unsigned slot = 1; slot < n_threads; ++slot) {
+        workers.emplace_back([this, slot] { run(slot); });
+    }
+}
+
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard lk(mtx);
+        stop = true;
+    }
+    cv_work.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+Thread_pool& Thread_pool::global()
+{
+    static Thread_pool pool;
+    return pool;
+}
+
+void Thread_pool::parallel_for(std::size_t n, std::size_t grain, const chunk_fn& fn)
+{
+    if (n == 0) return;
+    grain = std::max(grain, std::size_t(1));
+
+    if (workers.empty() || n <= grain || in_pool_work) {
+        // not worth (or not possible) to distribute
+        unsigned slot = in_pool_work ? pool_slot : 0;
+        for (std::size_t begin = 0; begin < n; begin += grain) {
+            fn(begin, std::min(begin + grain, n), slot);
+        }
+        return;
+    }
+
+    std::lock_guard submit_lk(submit_mtx);
+
+    // distribute the chunks round robin over the queues of all slots
+    std::size_t n_chunks = (n + grain - 1) / grain;
+    pending = n_chunks;
+    for (std::size_t c = 0; c < n_chunks; ++c) {
+        chunk_queue& cq = *queues[c % queues.size()];
+        std::lock_guard lk(cq.mtx);
+        cq.q.push_back(chunk{c * grain, std::min((c + 1) * grain, n)});
+    }
+
+    {
+        std::lock_guard lk(mtx);
+        job = &fn;
+        ++job_gen;
+        error = nullptr;
+    }
+    cv_work.notify_all();
+
+    in_pool_work = true;
+    pool_slot = 0;
+    work(0, fn);
+    in_pool_work = false;
+
+    std::exception_ptr e;
+    {
+        std::unique_lock lk(mtx);
+        cv_done.wait(lk, [this] { return pending == 0 && busy == 0; });
+        job = nullptr; // workers waking up late must not start on it anymore
+        e = error;
+    }
+    if (e) std::rethrow_exception(e);
+}
+
+void Thread_pool::run(unsigned slot)
+{
+    in_pool_work = true;
+    pool_slot = slot;
+
+    std::uint64_t seen_gen = 0;
+    while (true) {
+        const chunk_fn* fn = nullptr;
+        {
+            std::unique_lock lk(mtx);
+            cv_work.wait(lk, [&] { return stop || job_gen != seen_gen; });
+            if (stop) return;
+            seen_gen = job_gen;
+            if (job == nullptr) continue; // job finished already
+            fn = job;
+            ++busy;
+        }
+
+        work(slot, *fn);
+
+        {
+            std::lock_guard lk(mtx);
+            --busy;
+        }
+        cv_done.notify_all();
+    }
+}
+
+void Thread_pool::work(unsigned slot, const chunk_fn& fn)
+{
+    chunk c;
+    while (pop(slot, c)) {
+        try {
+            fn(c.begin, c.end, slot);
+        }
+        catch (...) {
+            std::lock_guard lk(mtx);
+            if (!error) error = std::current_exception();
+        }
+
+        if (--pending == 0) {
+            std::lock_guard lk(mtx);
+            cv_done.notify_all();
+        }
+    }
+}
+
+bool Thread_pool::pop(unsigned slot, chunk& c)
+{
+    // own queue first (in order), then steal from the back of the other queues
+    {
+        chunk_queue& cq = *queues[slot];
+        std::lock_guard lk(cq.mtx);
+        if (!cq.q.empty()) {
+            c = cq.q.front();
+            cq.q.pop_front();
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < queues.size(); ++k) {
+        chunk_queue& cq = *queues[(slot + k) % queues.size()];
+        std::lock_guard lk(cq.mtx);
+        if (!cq.q.empty()) {
+            c = cq.q.back();
+            cq.q.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#include "view_history.hpp"
+
+View_history::View_history(std::size_t max_steps, clock::duration coalesce_window) :
+    max_n{max_steps}, window{coalesce_window}
+{
+}
+
+void View_history::push(const view_state& vs, int kind)
+{
+    clock::time_point now = clock::now();
+    bool coalesce = kind != 0 && kind == last_kind && now - last_time <= window &&
+                    !undo_stack.empty();
+    last_kind = kind;
+    last_time = now;
+    redo_stack.clear();
+    if (coalesce) return; // the view before the first step of the series is kept
+
+    undo_stack.push_back(vs);
+    while (undo_stack.size() > max_n) {
+        undo_stack.pop_front();
+    }
+}
+
+bool View_history::undo(const view_state& current, view_state& previous)
+{
+    last_kind = 0; // a following change starts a new step
+    if (undo_stack.empty()) return false;
+
+    previous = undo_stack.back();
+    undo_stack.pop_back();
+    redo_stack.push_back(current);
+    return true;
+}
+
+bool View_history::redo(const view_state& current, view_state& next)
+{
+    last_kind = 0;
+    if (redo_stack.empty()) return false;
+
+    next = redo_stack.back();
+    redo_stack.pop_back();
+    undo_stack.push_back(current);
+    while (undo_stack.size() > max_n) {
+        undo_stack.pop_front();
+    }
+    return true;
+}
+
+void View_history::clear()
+{
+    undo_stack.clear();
+    redo_stack.clear();
+    last_kind = 0;
+}
+
+void View_history::set_max_steps(std::size_t n)
+{
+    max_n = n;
+    while (undo_stack.size() > max_n) {
+        undo_stack.pop_front();
+    }
+}
+
+std::size_t View_history::bytes() const
+{
+    return (undo_stack.size() + redo_stack.size()) * sizeof(view_state);
+}
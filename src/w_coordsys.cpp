@@ -17,15 +17,7 @@ w_Coordsys::w_Coordsys(Coordsys* cs, Coordsys_model* cm, QWidget* parent) :
     // later)
     vm.push_back(cm);
 
-    setMinimumSize(cs->x.widget_size(), cs->y.widget_size());
-    setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
-    updateGeometry();
-
-    // receive Mouse Move Events even when no button is pressed (default is false)
-    // required to inform the status bar about the current mouse position
-    setMouseTracking(true);
-    // Accept KeyPress and KeyRelease Events
-    setFocusPolicy(Qt::StrongFocus);
+    init();
 }
 
 w_Coordsys::w_Coordsys(Coordsys* cs, const std::vector<Coordsys_model*> vm,
@@ -37,6 +29,35 @@ w_Coordsys::w_Coordsys(Coordsys* cs, const std::vector<Coordsys_model*> vm,
     // set current model ptr to first entry
     cm = vm[0];
 
+    init();
+}
+
+w_Coordsys::w_Coordsys(Coordsys* cs, std::shared_ptr<Model_source> source,
+                       QWidget* parent) :
+    QWidget(parent),
+    cs(cs), source(std::move(source))
+{
+
+    // frames are built in the background (if the source supports it): the
+    // previous frame is shown until the frame selected is ready
+    this->source->on_frame_ready([this](std::size_t) {
+        QMetaObject::invokeMethod(this, [this] { frame_ready(); }, Qt::QueuedConnection);
+    });
+
+    // set current model ptr to first frame (an empty model until it is ready)
+    cm_hold = this->source->try_frame(0);
+    if (!cm_hold) {
+        cm_hold = std::make_shared<Coordsys_model>();
+        frame_wanted = 0;
+    }
+    cm = cm_hold.get();
+
+    init();
+}
+
+void w_Coordsys::init()
+{
+    // common part of all constructors (cs and cm are set)
     setMinimumSize(cs->x.widget_size(), cs->y.widget_size());
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
     updateGeometry();
@@ -46,6 +67,22 @@ w_Coordsys::w_Coordsys(Coordsys* cs, const std::vector<Coordsys_model*> vm,
     setMouseTracking(true);
     // Accept KeyPress and KeyRelease Events
     setFocusPolicy(Qt::StrongFocus);
+
+    // streaming series of the model are polled for new samples
+    connect(&stream_timer, &QTimer::timeout, this, &w_Coordsys::check_streams);
+    check_streams();
+
+    // pan and wheel input is applied once per frame at most
+    input_timer.setSingleShot(true);
+    input_timer.setTimerType(Qt::PreciseTimer);
+    input_timer.setInterval(16); // ~ display refresh rate
+    connect(&input_timer, &QTimer::timeout, this, &w_Coordsys::input_frame);
+}
+
+w_Coordsys::~w_Coordsys()
+{
+    // no more notifications of frames finished by the source
+    if (source) source->on_frame_ready({});
 }
 
 void w_Coordsys::resizeEvent(QResizeEvent* event)
@@ -57,26 +94,355 @@ void w_Coordsys::resizeEvent(QResizeEvent* event)
     }
 }
 
+void w_Coordsys::set_async_render(bool on)
+{
+    if (on && !renderer) {
+        // frames are finished on the worker thread: trigger a repaint in the
+        // gui thread to present them
+        renderer = std::make_unique<Render_thread>([this] {
+            QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+        });
+    }
+    if (!on) {
+        renderer.reset(); // cancels a running frame and joins the worker
+    }
+    update();
+}
+
+void w_Coordsys::edit_model(const std::function<void(Coordsys_model&)>& fn)
+{
+    if (renderer) renderer->cancel();
+    fn(*cm);
+    update();
+}
+
+void w_Coordsys::set_scroll_window(double width)
+{
+    scroll_width = width;
+    if (scroll_width <= 0.0 && stream_scroll) {
+        end_scroll_plot();
+        update();
+    }
+    check_streams();
+}
+
+void w_Coordsys::check_streams()
+{
+    if (cm->n_streams() == 0) {
+        stream_timer.stop();
+        return;
+    }
+    if (!stream_timer.isActive()) stream_timer.start(16); // ~ display refresh rate
+
+    // scroll window: keep the latest sample at the right border of the cs
+    double x_last;
+    if (scroll_width > 0.0 && cs->x.scaling() == axis_scal::linear &&
+        cm->streams_last_x(x_last)) {
+        if (std::abs(cs->x.max() - cs->x.min() - scroll_width) > 1.e-9 * scroll_width) {
+            // width of the window changed (i.e. a full frame is rendered)
+            if (stream_scroll) end_scroll_plot();
+            cs->adjust_to_zoom(x_last - scroll_width, x_last, cs->y.min(), cs->y.max());
+            update();
+            return;
+        }
+
+        // move the window by whole pixels, so the plot of the last paint can be
+        // moved along and only the exposed strip is rendered (see scroll_plot)
+        double px = cs->x.w_to_a(1) - cs->x.w_to_a(0);
+        double n_px = std::ceil((x_last - cs->x.max()) / px);
+        if (n_px != 0.0) {
+            if (!stream_scroll) {
+                plot_from_layer();
+                stream_scroll = true;
+            }
+            cs->adjust_to_pan(-n_px * px, 0.0);
+            update();
+            return;
+        }
+    }
+
+    // cleared streams need a full frame (see current_key), else new samples
+    const frame_key& shown = stream_scroll ? plot_key : layer_id;
+    if (cm->streams_epoch() != shown.cm_streams ||
+        cm->streams_appended(stream_scroll ? plot_streams : layer_streams)) {
+        update();
+    }
+}
+
 void w_Coordsys::paintEvent(QPaintEvent* e)
 {
     Q_UNUSED(e);
+
+    // streams added after construction are polled from now on
+    if (!stream_timer.isActive() && cm->n_streams() > 0) check_streams();
+
+    // the scroll window moves the plot as long as nothing else changed the view
+    if (stream_scroll && m_action != pz_action::pan && !plot_valid.isEmpty() &&
+        !plot_matches()) {
+        end_scroll_plot();
+    }
+
+    // a switched-in model is shown by a full frame (framePresented keeps the
+    // playback going), the moved plot is still of the previous one
+    if (switch_pending && stream_scroll) end_scroll_plot();
+
+    if (!switch_pending && (m_action == pz_action::pan || stream_scroll)) {
+        // moved plot area, the decorations are drawn directly
+        scroll_plot();
+        QPainter qp(this);
+        qp.drawImage(0, 0, plot);
+        qp.setRenderHint(QPainter::Antialiasing);
+        cs->draw_axes(&qp);
+        draw_zoom_rect(&qp);
+        return;
+    }
+
+    if (renderer) {
+        present_frame();
+    }
+    else {
+        update_layer();
+    }
+    draw_stream_increments();
+
+    if (switch_pending && layer_id == current_key()) {
+        switch_pending = false;
+        emit framePresented();
+    }
+
     QPainter qp(this);
+    qp.drawImage(0, 0, layer);
+
+    qp.setRenderHint(QPainter::Antialiasing);
+    draw_zoom_rect(&qp);
+}
+
+frame_key w_Coordsys::current_key()
+{
+    return frame_key{cs->version(), cm, cm->version(), cm->streams_epoch(), size(),
+                     devicePixelRatioF()};
+}
+
+void w_Coordsys::present_frame()
+{
+    // show the latest finished frame (might be outdated during pan and zoom)
+    // and request a new one if the view changed; a running outdated frame is
+    // finished first, so frames keep coming during continuous changes
+    frame_key key = current_key();
+
+    QImage frame;
+    frame_key fkey;
+    if (renderer->take_frame(frame, fkey, layer_streams)) {
+        layer = std::move(frame);
+        layer_id = fkey;
+    }
+
+    if (layer_id != key && renderer->requested() != key) {
+        renderer->request(*cs, cm, key, cm_hold); // keeps a frame of source alive
+    }
+}
+
+void w_Coordsys::update_layer()
+{
+    frame_key key = current_key();
+
+    if (key == layer_id && !layer.isNull()) return; // nothing relevant changed
+
+    // render at device resolution to stay sharp on high dpi screens
+    layer = QImage(size() * key.dpr, QImage::Format_ARGB32_Premultiplied);
+    layer.setDevicePixelRatio(key.dpr);
+    layer.fill(Qt::transparent);
+
+    QPainter qp(&layer);
     qp.setRenderHint(QPainter::Antialiasing);
     draw(&qp);
+
+    layer_id = key;
+}
+
+void w_Coordsys::draw_stream_increments()
+{
+    // only valid if the layer shows the current view
+    // (otherwise a full frame is on its way)
+    if (layer.isNull() || layer_id != current_key()) return;
+    if (!cm->streams_appended(layer_streams)) return;
+
+    QPainter qp(&layer);
+    qp.setRenderHint(QPainter::Antialiasing);
+    qp.setClipRect(cs_area());
+    cm->draw_appended(&qp, cs, layer_streams);
+}
+
+QRect w_Coordsys::cs_area() const
+{
+    return QRect(cs->x.nmin(), cs->y.nmax(), cs->x.nmax() - cs->x.nmin(),
+                 cs->y.nmin() - cs->y.nmax());
+}
+
+bool w_Coordsys::plot_matches()
+{
+    // anything but the position of the view changed: plot has to start over
+    frame_key key = current_key();
+    key.cs_version = 0; // changed by each pan
+    view_state vs = cs->get_view_state();
+    auto same_extent = [](const axis_rng& a, const axis_rng& b) {
+        return std::abs((a.max - a.min) - (b.max - b.min)) <= 1.e-9 * (a.max - a.min);
+    };
+    return !plot.isNull() && key == plot_key && same_extent(vs.x_rng, plot_view.x_rng) &&
+           same_extent(vs.y_rng, plot_view.y_rng) &&
+           vs.x_major_delta == plot_view.x_major_delta &&
+           vs.y_major_delta == plot_view.y_major_delta && vs.x_scal == plot_view.x_scal &&
+           vs.y_scal == plot_view.y_scal;
+}
+
+void w_Coordsys::plot_from_layer()
+{
+    // start with the last full frame if it shows the current view (w/o the
+    // border with axes and frame)
+    frame_key key = current_key();
+    if (layer.isNull() || layer_id != key) return;
+
+    plot = QImage(layer.size(), QImage::Format_ARGB32_Premultiplied);
+    plot.setDevicePixelRatio(key.dpr);
+    plot.fill(Qt::transparent);
+
+    int m = std::ceil(cs->style().theme.axis_pen.widthF()) + 1;
+    QRect valid = cs_area().adjusted(m, m, -m, -m);
+    QPainter qp(&plot);
+    qp.setClipRect(valid);
+    qp.drawImage(0, 0, layer);
+    qp.end();
+
+    key.cs_version = 0;
+    plot_valid = valid;
+    plot_view = cs->get_view_state();
+    plot_key = key;
+    plot_streams = layer_streams;
+}
+
+void w_Coordsys::scroll_plot()
+{
+    // the model is drawn here: a frame must not be rendered at the same time
+    if (renderer) renderer->cancel();
+
+    QRect area = cs_area();
+    if (!plot_matches()) plot_valid = QRect();
+    if (plot_valid.isEmpty()) plot_from_layer();
+
+    // shift of the content in pixels since the last paint
+    auto shift = [](const Axis& a, double old_min) {
+        return int(std::lround((old_min - a.min()) / (a.w_to_a(1) - a.w_to_a(0))));
+    };
+    int sx = plot_valid.isEmpty() ? 0 : shift(cs->x, plot_view.x_rng.min);
+    int sy = plot_valid.isEmpty() ? 0 : shift(cs->y, plot_view.y_rng.min);
+
+    if (sx == 0 && sy == 0 && plot_valid == area) {
+        // not moved: just add new samples of the streams
+        if (cm->streams_appended(plot_streams)) {
+            QPainter qp(&plot);
+            qp.setRenderHint(QPainter::Antialiasing);
+            qp.setClipRect(area);
+            cm->draw_appended(&qp, cs, plot_streams);
+        }
+        return;
+    }
+
+    frame_key key = current_key();
+    key.cs_version = 0;
+    if (plot_back.size() != size() * key.dpr) {
+        plot_back = QImage(size() * key.dpr, QImage::Format_ARGB32_Premultiplied);
+        plot_back.setDevicePixelRatio(key.dpr);
+    }
+    plot_back.fill(Qt::transparent);
+
+    QPainter qp(&plot_back);
+    qp.setRenderHint(QPainter::Antialiasing);
+
+    QRect valid; // part of the area taken from the previous image
+    if (!plot_valid.isEmpty()) {
+        valid = plot_valid.translated(sx, sy).intersected(area);
+        qp.save();
+        qp.setClipRect(valid);
+        qp.drawImage(sx, sy, plot);
+        // new samples of the streams in the moved part (before the strips are
+        // rendered: samples appended meanwhile are drawn by the strips)
+        cm->draw_appended(&qp, cs, plot_streams);
+        qp.restore();
+    }
+
+    if (valid.isEmpty()) {
+        draw_plot_part(&qp, area, &plot_streams);
+    }
+    else {
+        // strips above and below the valid part, left and right of it
+        const QRect strips[4] = {
+            QRect(area.left(), area.top(), area.width(), valid.top() - area.top()),
+            QRect(area.left(), valid.bottom() + 1, area.width(),
+                  area.bottom() - valid.bottom()),
+            QRect(area.left(), valid.top(), valid.left() - area.left(), valid.height()),
+            QRect(valid.right() + 1, valid.top(), area.right() - valid.right(),
+                  valid.height())};
+        for (const QRect& r : strips) {
+            if (!r.isEmpty()) draw_plot_part(&qp, r);
+        }
+    }
+    qp.end();
+
+    std::swap(plot, plot_back);
+    plot_valid = area;
+    plot_view = cs->get_view_state();
+    plot_key = key;
+}
+
+void w_Coordsys::draw_plot_part(QPainter* qp, const QRect& r,
+                                Coordsys_model::stream_state* drawn)
+{
+    // coordsys restricted to r: items of the model outside of r are culled
+    Coordsys cs_part = cs->part(r);
+    qp->save();
+    qp->setClipRect(r);
+    cs_part.draw_grid(qp);
+    cm->draw(qp, &cs_part, {}, drawn);
+    qp->restore();
+}
+
+void w_Coordsys::end_scroll_plot()
+{
+    stream_scroll = false;
+    if (plot_valid.isEmpty()) return;
+
+    // show the moved plot with decorations until the full frame is ready
+    layer = plot;
+    QPainter qp(&layer);
+    qp.setRenderHint(QPainter::Antialiasing);
+    cs->draw_axes(&qp);
+    qp.end();
+    layer_id = frame_key{}; // outdated: a full frame is rendered
+    layer_streams.clear();
+
+    plot_valid = QRect();
 }
 
 void w_Coordsys::draw(QPainter* qp)
 {
 
     cs->draw(qp);
-    cm->draw(qp, cs);
+    cm->draw(qp, cs, {}, &layer_streams);
 
     // fmt::print("w_Coorsys::draw\n");
+}
+
+void w_Coordsys::draw_zoom_rect(QPainter* qp)
+{
 
     if (m_leftButton) {
 
         qp->save();
-        qp->setPen(QPen(Qt::blue, 2, Qt::SolidLine));
+
+        // same clipping as for the model: active area of coordsys
+        qp->setClipRect(cs_area());
+
+        qp->setPen(cs->style().theme.zoom_pen);
         qp->setBrush(QColor(240, 230, 50, 128)); // transparent yellow
 
         switch (m_mode) {
@@ -103,6 +469,9 @@ void w_Coordsys::draw(QPainter* qp)
 void w_Coordsys::keyPressEvent(QKeyEvent* event)
 {
 
+    // pending input belongs to the current mode (and precedes undo/redo)
+    apply_input();
+
     // ignore key repetition, just change the mode if required
     if (event->key() == Qt::Key_X && m_mode != pz_mode::x_only) {
         m_mode = pz_mode::x_only;
@@ -115,14 +484,22 @@ void w_Coordsys::keyPressEvent(QKeyEvent* event)
         emit modeChanged(m_action, m_mode);
     }
     if (event->key() == Qt::Key_Z && (event->modifiers() & Qt::ControlModifier)) {
-        // call undo function to reinstate last coordsys
-        pop_from_history();
+        if (event->modifiers() & Qt::ShiftModifier) {
+            // reinstate the coordsys of the last undo
+            redo_history();
+        }
+        else {
+            // call undo function to reinstate last coordsys
+            pop_from_history();
+        }
     }
 }
 
 void w_Coordsys::keyReleaseEvent(QKeyEvent* event)
 {
 
+    apply_input();
+
     if (event->key() == Qt::Key_X) {
         m_mode = pz_mode::x_and_y;
         // fmt::print("X released\n");
@@ -138,6 +515,8 @@ void w_Coordsys::keyReleaseEvent(QKeyEvent* event)
 void w_Coordsys::mousePressEvent(QMouseEvent* event)
 {
 
+    apply_input(); // before undo info is stored
+
     // accept mouse presses only in hot area
     if (m_hot) {
         if (event->button() == Qt::LeftButton) {
@@ -161,7 +540,7 @@ void w_Coordsys::mousePressEvent(QMouseEvent* event)
 
             // store undo info (before pan starts, don't store intermediate steps)
             // call update to statusbar only on keyRelease, to not confuse the user
-            push_to_history();
+            push_to_history(pz_action::pan);
             emit modeChanged(m_action, m_mode);
         }
     }
@@ -170,6 +549,8 @@ void w_Coordsys::mousePressEvent(QMouseEvent* event)
 void w_Coordsys::mouseReleaseEvent(QMouseEvent* event)
 {
 
+    apply_input(); // complete pan before the final frame
+
     // end of zoom event triggered by release of left mouse button
     if (event->button() == Qt::LeftButton && m_leftButton) {
         // fmt::print("w_Coordsys::mouseReleaseEvent() left button\n");
@@ -199,7 +580,7 @@ void w_Coordsys::mouseReleaseEvent(QMouseEvent* event)
             // store undo info (only if zoom actually is performed)
             // and update statusbar emediately
             push_to_history();
-            emit undoChanged(cs_history.size()); // update undo info in status bar
+            emit undoChanged(cs_history.undo_steps(), cs_history.redo_steps());
 
             // adjust and update
             switch (m_mode) {
@@ -226,12 +607,16 @@ void w_Coordsys::mouseReleaseEvent(QMouseEvent* event)
 
             // fmt::print("w_Coordsys::mouseReleaseEvent() end of pan.\n\n");
 
-            // update statusbar (cs_history.size() was changed on keyPressEvent)
-            emit undoChanged(cs_history.size());
+            // update statusbar (cs_history was changed on mousePressEvent)
+            emit undoChanged(cs_history.undo_steps(), cs_history.redo_steps());
 
             m_rightButton = false;
             m_action = pz_action::none;
             emit modeChanged(m_action, m_mode);
+
+            // full frame of the final view
+            end_scroll_plot();
+            update();
         }
 
         if (m_hot) {
@@ -269,6 +654,11 @@ void w_Coordsys::mouseMoveEvent(QMouseEvent* event)
         mouse_pos_t mouse_pos{nx, ny, x_pos, y_pos};
         emit mouseMoved(hot, mouse_pos);
 
+        // item under the mouse (nearest within pick_tol pixels)
+        pick_result item;
+        bool found = hot && pick_tol > 0 && cm->pick(cs, nx, ny, pick_tol, item);
+        emit itemHovered(found, item);
+
         // current mouse position in hot area (needed for zoom rectangle)
         if (nx < cs->x.nmin()) {
             m_nx_hot = cs->x.nmin();
@@ -307,21 +697,10 @@ void w_Coordsys::mouseMoveEvent(QMouseEvent* event)
 
         // pan (only in hot area)
         if (m_rightButton && m_hot) {
-            double dx = x_pos - cs->x.w_to_a(m_nx);
-            double dy = y_pos - cs->y.w_to_a(m_ny);
-            // fmt::print("dx = {}, dy = {}\n", dx, dy);
-            switch (m_mode) {
-                case pz_mode::x_and_y:
-                    cs->adjust_to_pan(dx, dy);
-                    break;
-                case pz_mode::x_only:
-                    cs->adjust_to_pan(dx, 0.0);
-                    break;
-                case pz_mode::y_only:
-                    cs->adjust_to_pan(0.0, dy);
-                    break;
-            }
-            update();
+            // accumulated in pixels (applied by apply_input)
+            if (m_mode != pz_mode::y_only) pan_dnx += nx - m_nx;
+            if (m_mode != pz_mode::x_only) pan_dny += ny - m_ny;
+            queue_input();
         }
 
         // store current position
@@ -373,34 +752,86 @@ void w_Coordsys::wheelEvent(QWheelEvent* event)
     if (m_hot && (numTicks != 0)) {
 
         if (m_action == pz_action::none) {
-            // for new scrollwheel moves, store undo information
-
             // fmt::print("w_Coordsys::wheelEvent Begin.\n");
-
-            // store undo info only if wheel zoom actually is started
-            // and update statusbar immediately
             m_action = pz_action::wheel_zoom;
             emit modeChanged(m_action, m_mode);
+        }
 
-            push_to_history();
-            emit undoChanged(cs_history.size()); // update undo info in status bar
+        // pending input that cannot be merged with this event is applied first
+        if (pan_dnx != 0 || pan_dny != 0 ||
+            (wheel_scale != 1.0 && (wheel_nx != m_nx_hot || wheel_ny != m_ny_hot))) {
+            apply_input();
         }
 
+        // store undo info for each step: steps of a scrollwheel move are
+        // coalesced (end events are not reported reliably on all platforms)
+        // and update statusbar immediately
+        push_to_history(pz_action::wheel_zoom);
+        emit undoChanged(cs_history.undo_steps(), cs_history.redo_steps());
+
         // fmt::print("w_Coordsys::wheelEvent moving.\n");
 
         // numTicks is used for scaling: positive values for zoom in, negative for
         // zoom out center point for the scaling is the mouse cursor position
         // m_nx_hot, m_ny_hot
-        // the distance between the x- and y-values at the current mouse position
-        // and the current min- and max-positions are scaled
+        // scale factors of consecutive events are accumulated (applied by
+        // apply_input)
+        wheel_scale *= 1.0 - 0.01 * 0.25 * numTicks; // 4 numTicks = 1% scaling
+        wheel_nx = m_nx_hot;
+        wheel_ny = m_ny_hot;
+        queue_input();
+    }
+}
 
-        // fmt::print(
-        //     "Received a wheelEvent at m_nx_hot = {}, m_ny_hot = {}, m_hot = {}, "
-        //     "numTicks = {}\n",
-        //     m_nx_hot, m_ny_hot, m_hot, numTicks);
+void w_Coordsys::queue_input()
+{
+
+    ++in_stats.events;
+    input_pending = true;
+
+    // first change within a frame: apply at once (no additional latency),
+    // following input is merged until the frame is over
+    if (!input_timer.isActive()) {
+        apply_input();
+        input_timer.start();
+    }
+}
 
-        double x = cs->x.w_to_a(m_nx_hot);
-        double y = cs->y.w_to_a(m_ny_hot);
+void w_Coordsys::input_frame()
+{
+
+    if (input_pending) {
+        apply_input();
+        input_timer.start();
+    }
+}
+
+void w_Coordsys::apply_input()
+{
+
+    if (!input_pending) return;
+    input_pending = false;
+    ++in_stats.applied;
+
+    // pan (pixels to scaled values: the transformation is affine)
+    if (pan_dnx != 0 || pan_dny != 0) {
+        double dx = cs->x.w_to_a(pan_dnx) - cs->x.w_to_a(0);
+        double dy = cs->y.w_to_a(pan_dny) - cs->y.w_to_a(0);
+        // fmt::print("dx = {}, dy = {}\n", dx, dy);
+        cs->adjust_to_pan(dx, dy);
+        pan_dnx = 0;
+        pan_dny = 0;
+    }
+
+    // wheel zoom
+    if (wheel_scale != 1.0) {
+        // the distance between the x- and y-values at the center and the current
+        // min- and max-positions are scaled
+        double scale_fact = wheel_scale;
+        wheel_scale = 1.0;
+
+        double x = cs->x.w_to_a(wheel_nx);
+        double y = cs->y.w_to_a(wheel_ny);
 
         double dx_min = x - cs->x.min();
         double dx_max = cs->x.max() - x;
@@ -408,8 +839,6 @@ void w_Coordsys::wheelEvent(QWheelEvent* event)
         double dy_min = y - cs->y.min();
         double dy_max = cs->y.max() - y;
 
-        double scale_fact = 1.0 - 0.01 * 0.25 * numTicks; // 4 numTicks = 1% scaling
-
         double new_xmin = x - scale_fact * dx_min;
         double new_xmax = x + scale_fact * dx_max;
 
@@ -419,11 +848,7 @@ void w_Coordsys::wheelEvent(QWheelEvent* event)
         // fmt::print("new_xmin={}, new_xmax={}, new_ymin={}, new_ymax={}\n\n",
         //            new_xmin, new_xmax, new_ymin, new_ymax);
 
-        // fmt::print("w_coordsys::wheelEvent: xtarget_ratio = {}, ytarget_ratio =
-        // {}\n\n",
-        //            cs->get_xtarget_ratio(), cs->get_ytarget_ratio());
-
-        // adjust and update
+        // adjust
         switch (m_mode) {
             case pz_mode::x_and_y:
                 cs->adjust_to_wheel_zoom(new_xmin, new_xmax, new_ymin, new_ymax,
@@ -441,29 +866,39 @@ void w_Coordsys::wheelEvent(QWheelEvent* event)
                                          cs->get_ytarget_ratio());
                 break;
         }
-        update();
     }
+
+    update();
 }
 
-void w_Coordsys::push_to_history()
+void w_Coordsys::push_to_history(pz_action kind)
 {
 
-    // push a copy of the current cs into cs_history
-    cs_history.emplace_back(Coordsys(cs->x, cs->y, cs->get_coordsys_data()));
+    // store the compact view state of the current cs (drops the redo steps)
+    cs_history.push(cs->get_view_state(),
+                    kind == pz_action::none ? 0 : static_cast<int>(kind));
 }
 
 void w_Coordsys::pop_from_history()
 {
 
     // undo function to restore older version of cs
-    if (cs_history.size() > 0) {
-        // fmt::print("got undo signal: cs_history.size()={}\n",
-        // cs_history.size());
-        *cs = cs_history[cs_history.size() - 1];
-        cs_history.pop_back();
-        // just in case the widet was resized => adjust to current size
-        cs->adjust_to_resized_widget(width(), height());
-        emit undoChanged(cs_history.size()); // update undo info in status bar
+    // (applied to the current widget size)
+    view_state vs;
+    if (cs_history.undo(cs->get_view_state(), vs)) {
+        cs->set_view_state(vs);
+        emit undoChanged(cs_history.undo_steps(), cs_history.redo_steps());
+        update();
+    }
+}
+
+void w_Coordsys::redo_history()
+{
+
+    view_state vs;
+    if (cs_history.redo(cs->get_view_state(), vs)) {
+        cs->set_view_state(vs);
+        emit undoChanged(cs_history.undo_steps(), cs_history.redo_steps());
         update();
     }
 }
@@ -471,10 +906,53 @@ void w_Coordsys::pop_from_history()
 void w_Coordsys::switch_to_model(int idx)
 {
 
-    if (idx >= 0 && idx < vm.size()) {
+    if (source && idx >= 0 && std::size_t(idx) < source->size()) {
+        // shown by frame_ready as soon as it is built
+        frame_wanted = idx;
+        frame_ready();
+        return;
+    }
+    else if (!source && idx >= 0 && std::size_t(idx) < vm.size()) {
         // fmt::print("got signal {}\n", idx);
         cm = vm[idx];
-        emit labelChanged(cm->label());
-        update();
     }
+    else {
+        return;
+    }
+
+    model_switched();
+}
+
+void w_Coordsys::frame_ready()
+{
+    if (frame_wanted < 0) return;
+
+    // errors of the source are reported here: they must not leave the slot
+    // (which is called by the event loop)
+    std::shared_ptr<Coordsys_model> f;
+    try {
+        f = source->try_frame(frame_wanted);
+    }
+    catch (const std::exception& e) {
+        int idx = frame_wanted;
+        frame_wanted = -1;
+        emit frameFailed(idx, e.what());
+        return;
+    }
+    if (!f) return; // still being built
+
+    frame_wanted = -1;
+    // the previous frame stays alive as long as it is rendered
+    cm_hold = std::move(f);
+    cm = cm_hold.get();
+    model_switched();
+}
+
+void w_Coordsys::model_switched()
+{
+    layer_streams.clear();
+    switch_pending = true;
+    check_streams();
+    emit labelChanged(cm->label());
+    update();
 }
@@ -5,7 +5,8 @@
 #include <QPen>
 #include <QString>
 
-#include <cmath> // for axis scaling (and mathematical functions)
+#include <algorithm> // for std::min and std::max
+#include <cmath>     // for axis scaling (and mathematical functions)
 
 w_Cs_view::w_Cs_view(Coordsys* cs, Coordsys_model* cm, QWidget* parent) : QWidget(parent)
 {
@@ -30,27 +31,26 @@ w_Cs_view::w_Cs_view(Coordsys* cs, Coordsys_model* cm, QWidget* parent) : QWidge
     layout->addWidget(wsb);
     setLayout(layout);
 
-    // link coordsys to statusbar
-    connect(wcs, SIGNAL(mouseMoved(bool, mouse_pos_t)), wsb,
-            SLOT(on_mouseMoved(bool, mouse_pos_t)));
-    connect(wcs, SIGNAL(modeChanged(pz_action, pz_mode)), wsb,
-            SLOT(on_modeChanged(pz_action, pz_mode)));
-    connect(wcs, SIGNAL(undoChanged(int)), wsb, SLOT(on_undoChanged(int)));
-    connect(wcs, SIGNAL(labelChanged(std::string)), wsb,
-            SLOT(on_labelChanged(std::string)));
-    connect(wcs, SIGNAL(scalingChanged(axis_scal, axis_scal)), wsb,
-            SLOT(on_scalingChanged(axis_scal, axis_scal)));
-
-    // update status bar with label of first model
-    emit wcs->labelChanged(cm->label());
-
-    // update status bar with axis scaling
-    emit wcs->scalingChanged(cs->x.scaling(), cs->y.scaling());
+    link_statusbar(cs);
 }
 
 w_Cs_view::w_Cs_view(Coordsys* cs, const std::vector<Coordsys_model*> vm,
                      QWidget* parent) :
     QWidget(parent)
+{
+    wcs = new w_Coordsys(cs, vm, this);
+    setup_with_slider(cs, vm.size());
+}
+
+w_Cs_view::w_Cs_view(Coordsys* cs, std::shared_ptr<Model_source> source,
+                     QWidget* parent) :
+    QWidget(parent)
+{
+    wcs = new w_Coordsys(cs, source, this);
+    setup_with_slider(cs, source->size());
+}
+
+void w_Cs_view::setup_with_slider(Coordsys* cs, int n_models)
 {
 
     // set white as background color
@@ -59,12 +59,19 @@ w_Cs_view::w_Cs_view(Coordsys* cs, const std::vector<Coordsys_model*> vm,
     setAutoFillBackground(true);
     setPalette(pal);
 
-    wcs = new w_Coordsys(cs, vm, this);
-
     wsb = new w_Statusbar(cs->x.widget_size(), this);
 
     slider = new QSlider(Qt::Horizontal, this);
-    slider->setRange(0, vm.size() - 1); // only allow to switch between existing models
+    slider->setRange(0, n_models - 1); // only allow to switch between existing models
+
+    play_button = new QToolButton(this);
+    play_button->setText("Play");
+    play_button->setToolTip("Play models with 25 fps");
+
+    QHBoxLayout* play_layout = new QHBoxLayout;
+    play_layout->setContentsMargins(0, 0, 0, 0);
+    play_layout->addWidget(play_button);
+    play_layout->addWidget(slider);
 
     w1 = new QGroupBox;
     // w1->setFlat(true);
@@ -74,7 +81,7 @@ w_Cs_view::w_Cs_view(Coordsys* cs, const std::vector<Coordsys_model*> vm,
     layout->setSpacing(0);
     layout->addWidget(wcs);
     layout->addSpacing(5);
-    layout->addWidget(slider);
+    layout->addLayout(play_layout);
     layout->addSpacing(5);
     // layout->addStretch();
     layout->addWidget(wsb);
@@ -83,20 +90,134 @@ w_Cs_view::w_Cs_view(Coordsys* cs, const std::vector<Coordsys_model*> vm,
     // link slider to model selection
     connect(slider, SIGNAL(valueChanged(int)), wcs, SLOT(switch_to_model(int)));
     connect(slider, SIGNAL(valueChanged(int)), wsb, SLOT(on_modelChanged(int)));
+    // playback of models (stopped when the user grabs the slider)
+    play_timer.setSingleShot(true);
+    play_timer.setTimerType(Qt::PreciseTimer);
+    connect(&play_timer, SIGNAL(timeout()), this, SLOT(advance_playback()));
+    connect(play_button, SIGNAL(clicked()), this, SLOT(toggle_playback()));
+    connect(slider, SIGNAL(sliderPressed()), this, SLOT(stop()));
+    connect(wcs, SIGNAL(framePresented()), this, SLOT(on_framePresented()));
+    connect(wcs, SIGNAL(frameFailed(int, std::string)), this,
+            SLOT(on_frameFailed(int, std::string)));
+    connect(this, SIGNAL(playbackChanged(bool, double, int)), wsb,
+            SLOT(on_playbackChanged(bool, double, int)));
+
+    link_statusbar(cs);
+}
+
+void w_Cs_view::link_statusbar(Coordsys* cs)
+{
     // link coordsys to statusbar
     connect(wcs, SIGNAL(mouseMoved(bool, mouse_pos_t)), wsb,
             SLOT(on_mouseMoved(bool, mouse_pos_t)));
+    connect(wcs, SIGNAL(itemHovered(bool, pick_result)), wsb,
+            SLOT(on_itemHovered(bool, pick_result)));
     connect(wcs, SIGNAL(modeChanged(pz_action, pz_mode)), wsb,
             SLOT(on_modeChanged(pz_action, pz_mode)));
-    connect(wcs, SIGNAL(undoChanged(int)), wsb, SLOT(on_undoChanged(int)));
+    connect(wcs, SIGNAL(undoChanged(int,int)), wsb, SLOT(on_undoChanged(int, int)));
     connect(wcs, SIGNAL(labelChanged(std::string)), wsb,
             SLOT(on_labelChanged(std::string)));
     connect(wcs, SIGNAL(scalingChanged(axis_scal, axis_scal)), wsb,
             SLOT(on_scalingChanged(axis_scal, axis_scal)));
 
-    // update status bar with label of first model
-    emit wcs->labelChanged(vm[0]->label());
+    // update status bar with label of model shown
+    emit wcs->labelChanged(wcs->model_label());
 
     // update status bar with axis scaling
     emit wcs->scalingChanged(cs->x.scaling(), cs->y.scaling());
 }
+
+void w_Cs_view::play(double fps)
+{
+    if (slider == nullptr || fps <= 0.0) return;
+
+    // start again from the first model at the end
+    if (slider->value() == slider->maximum()) slider->setValue(slider->minimum());
+
+    playing = true;
+    frame_pending = false;
+    play_fps = fps;
+    play_first = slider->value();
+    play_dropped = 0;
+    stat_frames = 0;
+    play_clock.start();
+    stat_clock.start();
+    play_button->setText("Stop");
+
+    // the model shown now counts as the first frame
+    play_timer.start(static_cast<int>(1000.0 / play_fps));
+    emit playbackChanged(true, 0.0, 0);
+}
+
+void w_Cs_view::stop()
+{
+    if (!playing) return;
+
+    playing = false;
+    frame_pending = false;
+    play_timer.stop();
+    play_button->setText("Play");
+    emit playbackChanged(false, 0.0, play_dropped);
+}
+
+void w_Cs_view::toggle_playback()
+{
+    if (playing) {
+        stop();
+    }
+    else {
+        play(play_fps);
+    }
+}
+
+void w_Cs_view::advance_playback()
+{
+    if (!playing || frame_pending) return;
+
+    // model due now (according to the time since start of playback): models in
+    // between are skipped instead of queueing them, if rendering is too slow
+    int due = play_first + static_cast<int>(play_clock.elapsed() * play_fps / 1000.0);
+    due = std::min(due, slider->maximum());
+
+    int current = slider->value();
+    if (due <= current) {
+        // too early (timer resolution): wait for the next model to be due
+        qint64 t_next = (current - play_first + 1) * 1000.0 / play_fps;
+        play_timer.start(std::max<qint64>(1, t_next - play_clock.elapsed()));
+        return;
+    }
+
+    play_dropped += due - current - 1;
+    frame_pending = true;
+    slider->setValue(due); // switches the model and updates the status bar
+}
+
+void w_Cs_view::on_framePresented()
+{
+    if (!playing || !frame_pending) return;
+    frame_pending = false;
+
+    // achieved frame rate (reported about once per second)
+    ++stat_frames;
+    if (stat_clock.elapsed() >= 1000) {
+        double fps = stat_frames * 1000.0 / stat_clock.restart();
+        stat_frames = 0;
+        emit playbackChanged(true, fps, play_dropped);
+    }
+
+    if (slider->value() >= slider->maximum()) {
+        stop();
+        return;
+    }
+
+    // select the next model when it is due (immediately, if already late)
+    qint64 t_next = (slider->value() - play_first + 1) * 1000.0 / play_fps;
+    play_timer.start(std::max<qint64>(0, t_next - play_clock.elapsed()));
+}
+
+void w_Cs_view::on_frameFailed(int idx, std::string error)
+{
+    // the previous model is still shown: playback would wait for it forever
+    stop();
+    fmt::print(stderr, "model {} could not be built: {}\n", idx, error);
+}
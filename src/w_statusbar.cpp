@@ -46,12 +46,12 @@ void w_Statusbar::draw(QPainter* qp)
     qp->setPen(QPen(Qt::lightGray, 1, Qt::SolidLine));
     qp->drawRect(0, 0, w_width, w_height);
 
-    qp->setFont(QFont("Helvetica", 12, QFont::Normal));
+    qp->setFont(font);
     qp->setPen(QPen(Qt::black, 1, Qt::SolidLine));
-    QFontMetrics fm = qp->fontMetrics();
 
-    // print number of avialable undo steps
+    // print number of avialable undo (and redo) steps
     QString u = QString("#Undo: ") + QString::number(m_undo_steps);
+    if (m_redo_steps > 0) u += QString("  #Redo: ") + QString::number(m_redo_steps);
     int undo_len = fm.horizontalAdvance(u);
     qp->drawText(border_dist, nypos, u);
 
@@ -144,6 +144,19 @@ void w_Statusbar::draw(QPainter* qp)
 
         s = s1 + s2;
     }
+
+    // print id, group and coordinates of the item under the mouse
+    if (m_item_found) {
+        QString item = m_item.is_point ? QString("pt ") : QString("ln ");
+        item += QString::number(m_item.id);
+        if (!m_item.is_point || m_item.linked_to_id >= 0) {
+            item += QString("[") + QString::number(m_item.vertex) + QString("]");
+        }
+        item += QString(" grp ") + QString::number(m_item.grp) + QString(" (") +
+                QString::number(m_item.p.x, 'g', 6) + QString(", ") +
+                QString::number(m_item.p.y, 'g', 6) + QString(")");
+        s += QString("  ") + item;
+    }
     qp->drawText(w_width / 2 - fm.horizontalAdvance(s) / 2, nypos, s);
 
     // print index and (if present) label of currently displayed model
@@ -151,6 +164,10 @@ void w_Statusbar::draw(QPainter* qp)
     if (m_label != "") {
         step += QString("  Label: ") + m_label.c_str();
     }
+    if (m_playing) {
+        step += QString("  ") + QString::number(m_fps, 'f', 1) + QString(" fps, ") +
+                QString::number(m_dropped) + QString(" dropped");
+    }
     qp->drawText(w_width - fm.horizontalAdvance(step) - border_dist, nypos, step);
 
     qp->restore();
@@ -172,6 +189,19 @@ void w_Statusbar::on_mouseMoved(bool hot, mouse_pos_t mouse_pos)
     }
 }
 
+void w_Statusbar::on_itemHovered(bool found, pick_result item)
+{
+
+    if (m_item_found != found ||
+        (found && (m_item.is_point != item.is_point || m_item.id != item.id ||
+                   m_item.vertex != item.vertex))) {
+        // update only if another item is hovered
+        m_item_found = found;
+        m_item = item;
+        update();
+    }
+}
+
 void w_Statusbar::on_modelChanged(int step)
 {
 
@@ -195,13 +225,14 @@ void w_Statusbar::on_modeChanged(pz_action action, pz_mode mode)
     }
 }
 
-void w_Statusbar::on_undoChanged(int undo_steps)
+void w_Statusbar::on_undoChanged(int undo_steps, int redo_steps)
 {
 
-    if (m_undo_steps != undo_steps) {
+    if (m_undo_steps != undo_steps || m_redo_steps != redo_steps) {
         // update only if any value has changed
         // fmt::print("received undoChanged event: {}\n", undo_steps);
         m_undo_steps = undo_steps;
+        m_redo_steps = redo_steps;
         update();
     }
 }
@@ -227,4 +258,15 @@ void w_Statusbar::on_scalingChanged(axis_scal xscal, axis_scal yscal)
         m_yscaling = yscal;
         update();
     }
-}
\ No newline at end of file
+}
+void w_Statusbar::on_playbackChanged(bool playing, double fps, int dropped)
+{
+
+    if (m_playing != playing || m_fps != fps || m_dropped != dropped) {
+        // update only if any value has changed
+        m_playing = playing;
+        m_fps = fps;
+        m_dropped = dropped;
+        update();
+    }
+}